@@ -0,0 +1,132 @@
+#include "batch_runner.h"
+#include <algorithm>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "game_state.h"
+#include "game_sim.h"
+
+// Games [first_game, first_game + num_games)
+struct BatchTask {
+  std::uint32_t first_game;
+  std::uint32_t num_games;
+};
+
+// The owner takes tasks from the back, thieves from the front
+struct WorkQueue {
+  std::mutex mutex;
+  std::deque<BatchTask> tasks;
+};
+
+// Everything a worker needs to play games, never shared
+struct BatchWorkspace {
+  GameSim sim{};
+  GameState state{};
+  GameLayers layers{};
+  SimRandom policy_random{};
+};
+
+struct BatchRun {
+  const GameSim* level_sim;                 // built once, only read by the workers
+  PlayerPolicy policy;
+  void* user_data;
+  const BatchRunConfig* config;
+  GameResult* results;
+  std::uint32_t num_workers;
+  std::unique_ptr<WorkQueue[]> queues;
+};
+
+static bool pop_own_task(WorkQueue* queue, BatchTask* task) {
+  std::lock_guard<std::mutex> lock(queue->mutex);
+  if (queue->tasks.empty()) return false;
+  *task = queue->tasks.back();
+  queue->tasks.pop_back();
+  return true;
+}
+
+static bool steal_task(BatchRun* run, std::uint32_t thief, BatchTask* task) {
+  for (std::uint32_t offset = 1; offset < run->num_workers; ++offset) {
+    WorkQueue& victim = run->queues[(thief + offset) % run->num_workers];
+    std::lock_guard<std::mutex> lock(victim.mutex);
+    if (victim.tasks.empty()) continue;
+    *task = victim.tasks.front();
+    victim.tasks.pop_front();
+    return true;
+  }
+  return false;
+}
+
+static GameResult play_game(BatchRun* run, BatchWorkspace* workspace, std::uint32_t game_idx) {
+  const BatchRunConfig& config = *run->config;
+  GameSim& sim = workspace->sim;
+  GameState& state = workspace->state;
+
+  GameLayers* layers = &workspace->layers;
+  sim.reset(&state, config.seed, game_idx, layers);
+  workspace->policy_random = split_sim_random(&state.random);
+  sim.bind(&state, layers);
+
+  GameResult result = { GAME_STATUS::PLAYING, 0, 0 };
+  for (; result.steps < config.max_steps_per_game; ++result.steps) {
+    result.status = get_game_status(sim.tile_map, state.entities);
+    if (result.status != GAME_STATUS::PLAYING) break;
+
+    const MOVEMENT_DIR action = run->policy(sim.tile_map, state.entities,
+                                              &workspace->policy_random, run->user_data);
+    sim.step(&state, action, SIM_TICK_DT, layers);
+  }
+  result.collected_dots = state.entities.collected_dots;
+  return result;
+}
+
+static void run_worker(BatchRun* run, std::uint32_t worker) {
+  auto workspace = std::make_unique<BatchWorkspace>();
+  init_game_sim_from(&workspace->sim, *run->level_sim);
+
+  // No task ever spawns new ones, once nothing is left to steal we're done
+  BatchTask task = {};
+  while (pop_own_task(&run->queues[worker], &task) || steal_task(run, worker, &task)) {
+    for (std::uint32_t i = 0; i < task.num_games; ++i) {
+      const std::uint32_t game_idx = task.first_game + i;
+      run->results[game_idx] = play_game(run, workspace.get(), game_idx);
+    }
+  }
+}
+
+void run_games_batched(const TileMap& level_map, const EntityStore& level_entities,
+                       std::uint32_t num_games, PlayerPolicy policy, void* user_data,
+                       const BatchRunConfig& config, GameResult* results) {
+  if (num_games == 0) return;
+
+  // Exit masks, distance fields and hash keys are built once for all workers
+  GameSim level_sim;
+  if (!init_game_sim_shared(&level_sim, level_map, level_entities, config.sim)) return;
+
+  const std::uint32_t games_per_task = std::max(config.games_per_task, 1u);
+  const std::uint32_t num_tasks = (num_games + games_per_task - 1) / games_per_task;
+  std::uint32_t num_workers = config.num_threads ? config.num_threads
+                                                 : std::thread::hardware_concurrency();
+  num_workers = std::clamp(num_workers, 1u, num_tasks);
+
+  BatchRun run = { &level_sim, policy, user_data, &config, results,
+                   num_workers, std::make_unique<WorkQueue[]>(num_workers) };
+
+  // Contiguous shares, so workers mostly write to their own part of results
+  for (std::uint32_t task_idx = 0; task_idx < num_tasks; ++task_idx) {
+    const std::uint32_t first_game = task_idx * games_per_task;
+    const BatchTask task = { first_game, std::min(games_per_task, num_games - first_game) };
+    const std::uint32_t worker = static_cast<std::uint32_t>(
+      std::uint64_t(task_idx) * num_workers / num_tasks);
+    run.queues[worker].tasks.push_back(task);
+  }
+
+  std::vector<std::thread> threads;
+  threads.reserve(num_workers - 1);
+  for (std::uint32_t worker = 1; worker < num_workers; ++worker) {
+    threads.emplace_back(run_worker, &run, worker);
+  }
+  run_worker(&run, 0);
+  for (std::thread& thread : threads) thread.join();
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include <cstdint>
+#include "tile_map.h"
+#include "entity.h"
+#include "movement_dir.h"
+#include "sim.h"
+#include "sim_random.h"
+#include "game_sim.h"
+
+// Plays many independent games on all cores. Games are handed out in tasks
+// of games_per_task, every worker starts with its own contiguous share of
+// tasks and steals from the others once it runs dry. Workers own their
+// GameSim and GameState, the level and the data derived from it (exit
+// masks, distance fields, hash keys) are built once and only read.
+//
+// Each game seeds its own random stream from (seed, game index), so results
+// don't depend on the number of threads or on which worker ended up
+// playing a game.
+
+struct BatchRunConfig {
+  std::uint32_t num_threads{0};             // 0 for one per hardware thread
+  std::uint32_t games_per_task{64};
+  std::uint32_t max_steps_per_game{120 * 60 * 5};
+  std::uint64_t seed{1};
+  GameSimConfig sim{};                      // ghosts and pen setup
+};
+
+struct GameResult {
+  GAME_STATUS status;                       // PLAYING if the game timed out
+  std::uint32_t collected_dots;
+  std::uint32_t steps;
+};
+
+// Called before every step, returns the player's next direction or STOPPED
+// to keep going. random is a stream of the game's own, split from the
+// ghosts' one. Runs on the worker threads, so anything behind user_data has
+// to be safe to read concurrently.
+using PlayerPolicy = MOVEMENT_DIR (*)(const TileMap& tile_map, const EntityStore& entities,
+                                      SimRandom* random, void* user_data);
+
+// Fills results[num_games], blocks until every game is done. The level has
+// to fit in a GameState (see fits_game_state()), nothing is played otherwise.
+void run_games_batched(const TileMap& level_map, const EntityStore& level_entities,
+                       std::uint32_t num_games, PlayerPolicy policy, void* user_data,
+                       const BatchRunConfig& config, GameResult* results);
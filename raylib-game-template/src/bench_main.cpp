@@ -0,0 +1,394 @@
+// Micro benchmarks of the simulation and rendering hot paths. Results are
+// printed to stdout as JSON, one entry per case with its ns/op, so runs
+// before and after an engine change can be diffed by a script.
+//
+// Usage: pacman_bench [maze_scale|<cols>x<rows>] [min_seconds_per_case] [--no-render]
+//
+// maze_scale tiles the classic maze that many times in both directions, the
+// entities of the first copy only are kept. <cols>x<rows> uses a generated
+// maze of that size instead (see maze_gen.h). --no-render skips the cases
+// that need a window, e.g. on machines without a GPU. The move_to_tile_bfs
+// cases are skipped on mazes with more than BENCH_MAX_BFS_TILES walkable
+// tiles, every target they reach costs a BFS over the whole maze.
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "raylib.h"
+#include "level.h"
+#include "classic_level.h"
+#include "movement_dir.h"
+#include "entity.h"
+#include "tile_map.h"
+#include "ghosts.h"
+#include "player.h"
+#include "sim.h"
+#include "sim_random.h"
+#include "tile_exit_masks.h"
+#include "nav.h"
+#include "wall_mesh.h"
+#include "level_file.h"
+#include "maze_gen.h"
+#include "game_sim.h"
+#include "render.h"
+
+static constexpr std::uint32_t BENCH_MAX_BFS_TILES = 64 * 1024;
+
+struct BenchResult {
+  std::string name;
+  std::uint64_t ops;
+  double seconds;
+};
+
+// Keeps the compiler from dropping work whose result isn't used otherwise
+static volatile std::uint32_t bench_sink = 0;
+
+// Calls fn(), which does ops_per_call operations, in ever bigger batches
+// until a batch takes at least min_seconds
+template<typename Fn>
+static BenchResult run_bench(std::string name, double min_seconds, std::uint64_t ops_per_call,
+                             Fn&& fn) {
+  for (std::uint64_t calls = 1;; calls *= 2) {
+    const auto start = std::chrono::steady_clock::now();
+    for (std::uint64_t call = 0; call < calls; ++call) fn();
+    const auto end = std::chrono::steady_clock::now();
+
+    const double seconds = std::chrono::duration<double>(end - start).count();
+    if (seconds >= min_seconds || calls >= (std::uint64_t(1) << 40)) {
+      return BenchResult{ std::move(name), calls * ops_per_call, seconds };
+    }
+  }
+}
+
+// The classic maze repeated scale x scale times. Teleports only work on the
+// map's edges and a level has one player, so everything else is cleared.
+static std::vector<std::string> make_bench_level(std::uint16_t scale) {
+  const auto& classic = get_classic_level();
+  std::vector<std::string> lines;
+
+  for (std::uint16_t copy_row = 0; copy_row < scale; ++copy_row) {
+    for (const std::string& classic_line : classic) {
+      std::string line;
+      for (std::uint16_t copy_col = 0; copy_col < scale; ++copy_col) {
+        std::string part = classic_line;
+        if (copy_row != 0 || copy_col != 0) {
+          for (char& ch : part) {
+            if (ch == 'P' || ch == 'B' || ch == 'I' || ch == 'K' || ch == 'C') ch = ' ';
+          }
+        }
+        line += part;
+      }
+      for (std::size_t col = 1; col + 1 < line.size(); ++col) {
+        if (line[col] == '=') line[col] = ' ';
+      }
+      lines.push_back(std::move(line));
+    }
+  }
+  return lines;
+}
+
+static const char* get_ghost_type_name(GHOST_TYPE type) {
+  switch (type) {
+  case GHOST_TYPE::BLINKY: return "blinky";
+  case GHOST_TYPE::PINKY:  return "pinky";
+  case GHOST_TYPE::INKY:   return "inky";
+  case GHOST_TYPE::CLYDE:  return "clyde";
+  default:                 return "none";
+  }
+}
+
+static const char* get_ghost_state_name(GHOST_STATE state) {
+  switch (state) {
+  case GHOST_STATE::SCATTER:    return "scatter";
+  case GHOST_STATE::CHASE:      return "chase";
+  case GHOST_STATE::FRIGHTENED: return "frightened";
+  default:                      return "none";
+  }
+}
+
+int main(int argc, char** argv) {
+  unsigned int gen_cols = 0;
+  unsigned int gen_rows = 0;
+  const bool generated       = (argc > 1) && std::sscanf(argv[1], "%ux%u", &gen_cols, &gen_rows) == 2;
+  const std::uint16_t scale  = (argc > 1 && !generated) ? static_cast<std::uint16_t>(std::strtoul(argv[1], nullptr, 10)) : 1;
+  const double min_seconds   = (argc > 2) ? std::strtod(argv[2], nullptr) : 0.2;
+  const bool render          = !((argc > 3) && std::strcmp(argv[3], "--no-render") == 0);
+  if (scale == 0) {
+    std::fprintf(stderr, "maze_scale has to be at least 1\n");
+    return 1;
+  }
+
+  MazeGenConfig gen_config = {};
+  gen_config.cols = static_cast<std::uint16_t>(std::min(gen_cols, MAX_LEVEL_SIZE));
+  gen_config.rows = static_cast<std::uint16_t>(std::min(gen_rows, MAX_LEVEL_SIZE));
+  const std::vector<std::string> level = generated ? generate_maze_lines(gen_config) : make_bench_level(scale);
+  if (level.empty()) {
+    std::fprintf(stderr, "can't generate a %ux%u maze\n", gen_cols, gen_rows);
+    return 1;
+  }
+
+  static constexpr MOVEMENT_DIR dirs[4] = { MOVEMENT_DIR::UP, MOVEMENT_DIR::DOWN,
+                                            MOVEMENT_DIR::LEFT, MOVEMENT_DIR::RIGHT };
+  auto [level_map, level_entities] = parse_level(level, CLASSIC_TILE_SIZE);
+  const TileMap& tile_map = *level_map;
+  TilePos pen_door = CLASSIC_PEN_DOOR;
+  TilePos pen_home = CLASSIC_PEN_HOME;
+  find_level_pen(tile_map, &pen_door, &pen_home);
+  const std::uint32_t total_tiles = std::uint32_t(tile_map.cols) * tile_map.rows;
+
+  TileExitMasks exit_masks = {};
+  sync_tile_exit_masks(&exit_masks, tile_map);
+  // Fields are built as the ghosts ask for them, building all of them is
+  // quadratic in the maze size
+  DistanceFieldCache distance_fields = {};
+  sync_distance_fields(&distance_fields, tile_map);
+  const bool bfs_cases = distance_fields.num_walkable <= BENCH_MAX_BFS_TILES;
+
+  std::vector<BenchResult> results;
+
+  results.push_back(run_bench("parse_level", min_seconds, 1, [&]() {
+    auto parsed = parse_level(level, CLASSIC_TILE_SIZE);
+    bench_sink = bench_sink + parsed.first->all_dots;
+  }));
+
+  if (generated) {
+    results.push_back(run_bench("generate_maze_lines", min_seconds, 1, [&]() {
+      bench_sink = bench_sink + static_cast<std::uint32_t>(generate_maze_lines(gen_config).size());
+    }));
+  }
+
+  std::vector<TileRect> wall_rects;
+  results.push_back(run_bench("build_wall_rects", min_seconds, 1, [&]() {
+    build_wall_rects(tile_map, &wall_rects);
+    bench_sink = bench_sink + static_cast<std::uint32_t>(wall_rects.size());
+  }));
+
+  results.push_back(run_bench("tile_map_get_int", min_seconds, total_tiles, [&]() {
+    std::uint32_t sum = 0;
+    for (std::uint16_t row = 0; row < tile_map.rows; ++row) {
+      for (std::uint16_t col = 0; col < tile_map.cols; ++col) {
+        sum += static_cast<std::uint32_t>(tile_map.get(col, row));
+      }
+    }
+    bench_sink = bench_sink + sum;
+  }));
+
+  results.push_back(run_bench("tile_map_get_float", min_seconds, total_tiles, [&]() {
+    std::uint32_t sum = 0;
+    for (std::uint16_t row = 0; row < tile_map.rows; ++row) {
+      for (std::uint16_t col = 0; col < tile_map.cols; ++col) {
+        sum += static_cast<std::uint32_t>(tile_map.get(col + 0.5f, row + 0.5f));
+      }
+    }
+    bench_sink = bench_sink + sum;
+  }));
+
+  {
+    // Turns every now and then, eating its way through the maze
+    TileMap player_map;
+    player_map.copy_from(tile_map);
+    EntityStore entities = *level_entities;
+    std::uint32_t call = 0;
+    results.push_back(run_bench("update_player", min_seconds, 1, [&]() {
+      if ((++call & 63) == 0) entities.next_dir[PLAYER_ID] = dirs[(call >> 6) & 3];
+      bench_sink = bench_sink + static_cast<std::uint32_t>(
+        update_player(&player_map, &entities, &exit_masks, SIM_TICK_DT));
+    }));
+  }
+
+  {
+    GhostsStateMachine ghosts_sm = {};
+    std::uint32_t call = 0;
+    results.push_back(run_bench("update_ghosts_global_sm", min_seconds, 1, [&]() {
+      // Goes through the schedule, frightened every now and then
+      const bool energized = (++call & 4095) < 256;
+      update_ghosts_global_sm(&ghosts_sm, energized, CLASSIC_SCATTER_SCHEDULE,
+                              CLASSIC_CHASE_SCHEDULE, SIM_TICK_DT);
+      bench_sink = bench_sink + ghosts_sm.change_seq;
+    }));
+  }
+
+  // update_ghost runs every tick, most of which just advance the move
+  // timer. move_to_tile cases step a tile every call, so each one makes a
+  // decision (straight line, or shortest path with _bfs).
+  for (GHOST_TYPE type : { GHOST_TYPE::BLINKY, GHOST_TYPE::PINKY, GHOST_TYPE::INKY, GHOST_TYPE::CLYDE }) {
+    for (GHOST_STATE state : { GHOST_STATE::SCATTER, GHOST_STATE::CHASE, GHOST_STATE::FRIGHTENED }) {
+      for (const char* variant : { "update_ghost", "move_to_tile", "move_to_tile_bfs" }) {
+        const bool per_tile = std::strcmp(variant, "update_ghost") != 0;
+        const bool bfs = std::strcmp(variant, "move_to_tile_bfs") == 0;
+        if (bfs && !bfs_cases) continue;
+
+        EntityStore entities = *level_entities;
+        const EntityId ghost = find_ghost(entities, type);
+        if (ghost == NO_ENTITY) continue;
+
+        GhostsStateMachine ghosts_sm = {};
+        ghosts_sm.state = state;
+        SimRandom random = {};
+        seed_sim_random(&random, 1);
+        const GhostContext ghost_ctx{
+          tile_map,
+          ghosts_sm,
+          entities,
+          find_ghost(entities, GHOST_TYPE::BLINKY),
+          pen_door,
+          pen_home,
+          &random,
+          bfs ? &distance_fields : nullptr,
+          &exit_masks
+        };
+        const float dt = per_tile ? entities.tile_step_time[ghost] : SIM_TICK_DT;
+
+        // Out of the pen before measuring
+        for (std::uint32_t i = 0; i < 64; ++i) update_ghost(&entities, ghost, ghost_ctx, entities.tile_step_time[ghost]);
+
+        const std::string name = std::string(variant) + "/" + get_ghost_type_name(type) + "/" +
+                                 get_ghost_state_name(state);
+        results.push_back(run_bench(name, min_seconds, 1, [&]() {
+          update_ghost(&entities, ghost, ghost_ctx, dt);
+          bench_sink = bench_sink + static_cast<std::uint32_t>(entities.tile_pos[ghost].col);
+        }));
+      }
+    }
+  }
+
+  // Whole ticks with a random player, the level starts over when a game ends
+  {
+    TileMap game_map;
+    game_map.copy_from(tile_map);
+    EntityStore entities = *level_entities;
+    GhostsStateMachine ghosts_sm = {};
+    SimRandom random = {};
+    seed_sim_random(&random, 1);
+    const GhostContext ghost_ctx{
+      game_map,
+      ghosts_sm,
+      entities,
+      find_ghost(entities, GHOST_TYPE::BLINKY),
+      pen_door,
+      pen_home,
+      &random,
+      nullptr,
+      &exit_masks
+    };
+    results.push_back(run_bench("step_game", min_seconds, 1, [&]() {
+      if (get_game_status(game_map, entities) != GAME_STATUS::PLAYING) {
+        game_map.copy_from(tile_map);
+        entities = *level_entities;
+        ghosts_sm = GhostsStateMachine{};
+      }
+      if (entities.dir[PLAYER_ID] == MOVEMENT_DIR::STOPPED || get_sim_random_value(&random, 0, 31) == 0) {
+        entities.next_dir[PLAYER_ID] = dirs[get_sim_random_value(&random, 0, 3)];
+      }
+      step_game(&game_map, &entities, &ghosts_sm, ghost_ctx,
+                CLASSIC_SCATTER_SCHEDULE, CLASSIC_CHASE_SCHEDULE, SIM_TICK_DT);
+    }));
+  }
+  const double ticks_per_sec = results.back().ops / results.back().seconds;
+
+  // The same through GameSim, which agents and the headless driver use, on
+  // a level of any size. Counts the games that end, won or lost.
+  std::uint64_t game_sim_games = 0;
+  {
+    GameSimConfig sim_config = {};
+    sim_config.pen_door = pen_door;
+    sim_config.pen_home = pen_home;
+    auto sim = std::make_unique<GameSim>();
+    if (!init_game_sim(sim.get(), tile_map, *level_entities, sim_config)) {
+      std::fprintf(stderr, "GameSim can't play a %ux%u maze\n", tile_map.cols, tile_map.rows);
+      return 1;
+    }
+    GameState state = {};
+    GameLayers layers = {};
+    sim->reset(&state, 1, 0, &layers);
+    SimRandom random = {};
+    seed_sim_random(&random, 2);
+    results.push_back(run_bench("game_sim_step", min_seconds, 1, [&]() {
+      MOVEMENT_DIR action = MOVEMENT_DIR::STOPPED;
+      if (get_sim_random_value(&random, 0, 31) == 0) action = dirs[get_sim_random_value(&random, 0, 3)];
+      if (sim->step(&state, action, SIM_TICK_DT, &layers).status != GAME_STATUS::PLAYING) {
+        ++game_sim_games;
+        sim->reset(&state, 1, game_sim_games, &layers);
+      }
+    }));
+  }
+
+  // Drawn into an offscreen target of the game's window size, the cached
+  // path only draws what a camera on the player sees. Only the CPU side is
+  // timed, the GPU may still be busy when a call returns.
+  if (render) {
+    SetTraceLogLevel(LOG_NONE);
+    SetConfigFlags(FLAG_WINDOW_HIDDEN);
+    InitWindow(64, 64, "pacman_bench");
+
+    auto render_store = std::make_unique<EntityRenderStore>();
+    load_entities_textures(render_store.get(), *level_entities);
+    const int screen_width = std::min(tile_map.cols * tile_map.tile_size, 1280);
+    const int screen_height = std::min(tile_map.rows * tile_map.tile_size, 960);
+    const RenderTexture2D target = LoadRenderTexture(screen_width, screen_height);
+    const Camera2D camera = get_follow_camera(tile_map, get_entity_draw_pos(tile_map, *level_entities, PLAYER_ID, 0.0f),
+                                              screen_width, screen_height);
+    const Rectangle view = get_camera_view(camera, screen_width, screen_height);
+
+    results.push_back(run_bench("draw_map_and_entities/immediate", min_seconds, 1, [&]() {
+      BeginTextureMode(target);
+      ClearBackground(RAYWHITE);
+      draw_map_and_entities(tile_map, *level_entities, render_store.get(), nullptr,
+                            GHOST_STATE::SCATTER, SIM_TICK_DT, 0.0f);
+      EndTextureMode();
+    }));
+
+    MapRenderCache map_cache = {};
+    sync_map_render_cache(&map_cache, tile_map, &view);
+    results.push_back(run_bench("draw_map_and_entities/cached", min_seconds, 1, [&]() {
+      sync_map_render_cache(&map_cache, tile_map, &view);
+      BeginTextureMode(target);
+      ClearBackground(RAYWHITE);
+      BeginMode2D(camera);
+      draw_map_and_entities(tile_map, *level_entities, render_store.get(), &map_cache,
+                            GHOST_STATE::SCATTER, SIM_TICK_DT, 0.0f);
+      EndMode2D();
+      EndTextureMode();
+    }));
+
+    // A dot eaten (or put back) every call
+    TileMap patched_map;
+    patched_map.copy_from(tile_map);
+    sync_map_render_cache(&map_cache, patched_map, &view);
+    const TilePos dot_pos = level_entities->tile_pos[PLAYER_ID] + TilePos{ 1, 0 };
+    results.push_back(run_bench("sync_map_render_cache/patch", min_seconds, 1, [&]() {
+      const bool has_dot = patched_map.get(dot_pos) == TILE_TYPE::DOT;
+      patched_map.set(dot_pos, has_dot ? TILE_TYPE::EMPTY : TILE_TYPE::DOT);
+      sync_map_render_cache(&map_cache, patched_map, &view);
+    }));
+    unload_map_render_cache(&map_cache);
+
+    UnloadRenderTexture(target);
+    unload_entities_textures(render_store.get());
+    CloseWindow();
+  }
+
+  std::printf("{\n");
+  std::printf("  \"maze\": { \"scale\": %u, \"generated\": %s, \"cols\": %u, \"rows\": %u, \"bfs_cases\": %s },\n",
+              generated ? 0u : scale, generated ? "true" : "false", tile_map.cols, tile_map.rows,
+              bfs_cases ? "true" : "false");
+  std::printf("  \"ticks_per_sec\": %.1f,\n", ticks_per_sec);
+  std::printf("  \"game_sim_games\": %llu,\n", static_cast<unsigned long long>(game_sim_games));
+  std::printf("  \"results\": [\n");
+  for (std::size_t i = 0; i < results.size(); ++i) {
+    const BenchResult& result = results[i];
+    std::printf("    { \"name\": \"%s\", \"ops\": %llu, \"ns_per_op\": %.3f, \"ops_per_sec\": %.1f }%s\n",
+                result.name.c_str(), static_cast<unsigned long long>(result.ops),
+                result.seconds * 1e9 / result.ops, result.ops / result.seconds,
+                (i + 1 < results.size()) ? "," : "");
+  }
+  std::printf("  ]\n");
+  std::printf("}\n");
+  return 0;
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include <cstdint>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// Portable popcount/ctz for the 64-bit tile bitboards (we're on C++17,
+// no <bit> yet)
+inline std::uint32_t popcount64(std::uint64_t x) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+  return static_cast<std::uint32_t>(__builtin_popcountll(x));
+#else
+  x = x - ((x >> 1) & 0x5555555555555555ull);
+  x = (x & 0x3333333333333333ull) + ((x >> 2) & 0x3333333333333333ull);
+  x = (x + (x >> 4)) & 0x0f0f0f0f0f0f0f0full;
+  return static_cast<std::uint32_t>((x * 0x0101010101010101ull) >> 56);
+#endif
+}
+
+// Index of the lowest set bit, x must not be 0
+inline std::uint32_t ctz64(std::uint64_t x) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+  return static_cast<std::uint32_t>(__builtin_ctzll(x));
+#elif defined(_MSC_VER) && defined(_M_X64)
+  unsigned long idx = 0;
+  _BitScanForward64(&idx, x);
+  return static_cast<std::uint32_t>(idx);
+#else
+  std::uint32_t idx = 0;
+  while (!(x & 1)) { x >>= 1; ++idx; }
+  return idx;
+#endif
+}
+
+// Bits of columns [start, end) that fall into the given word of a row
+inline std::uint64_t get_span_mask(std::uint32_t word, std::uint32_t start, std::uint32_t end) noexcept {
+  const std::uint32_t lo = (start > word * 64u) ? start : word * 64u;
+  const std::uint32_t hi = (end < word * 64u + 64u) ? end : word * 64u + 64u;
+  if (lo >= hi) return 0;
+
+  const std::uint32_t count = hi - lo;
+  const std::uint64_t mask = (count == 64u) ? ~std::uint64_t(0) : (std::uint64_t(1) << count) - 1u;
+  return mask << (lo - word * 64u);
+}
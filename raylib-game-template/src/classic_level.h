@@ -0,0 +1,62 @@
+#pragma once
+#include <cstdint>
+#include <array>
+#include <string>
+#include <limits>
+#include "tile_pos.h"
+
+// The classic 28x36 maze, its ghost pen and scatter/chase schedules.
+// Shared by the windowed game and the headless simulation driver.
+constexpr std::uint16_t CLASSIC_TILE_SIZE = 24;
+constexpr std::uint16_t CLASSIC_NUM_TILES_X = 28;
+constexpr std::uint16_t CLASSIC_NUM_TILES_Y = 36;
+
+constexpr TilePos CLASSIC_PEN_DOOR = { 13, 14 };
+constexpr TilePos CLASSIC_PEN_HOME = { 13, 17 };
+
+// Ghosts time schedule for scattering and chasing, in seconds
+constexpr double CLASSIC_SCATTER_SCHEDULE[4] = {7.0, 7.0, 5.0, 5.0};
+constexpr double CLASSIC_CHASE_SCHEDULE[4]   = {20.0, 20.0, 20.0,
+                                                std::numeric_limits<double>::infinity()};
+
+inline const std::array<std::string, CLASSIC_NUM_TILES_Y>& get_classic_level() {
+  static const std::array<std::string, CLASSIC_NUM_TILES_Y> level = {
+    "                            ",
+    "                            ",
+    "                            ",
+    "############################",
+    "#............##............#",
+    "#.####.#####.##.#####.####.#",
+    "#O####.#####.##.#####.####O#",
+    "#.####.#####.##.#####.####.#",
+    "#..........................#",
+    "#.####.##.########.##.####.#",
+    "#.####.##.########.##.####.#",
+    "#......##....##....##......#",
+    "######.##### ## #####.######",
+    "     #.##### ## #####.#     ",
+    "     #.##    B     ##.#     ",
+    "     #.## ###--### ##.#     ",
+    "######.## #      # ##.######",
+    "=     .   #I K C #   .     =",
+    "######.## #      # ##.######",
+    "     #.## ######## ##.#     ",
+    "     #.##          ##.#     ",
+    "     #.## ######## ##.#     ",
+    "######.## ######## ##.######",
+    "#............##............#",
+    "#.####.#####.##.#####.####.#",
+    "#.####.#####.##.#####.####.#",
+    "#O..##.......P .......##..O#",
+    "###.##.##.########.##.##.###",
+    "###.##.##.########.##.##.###",
+    "#......##....##....##......#",
+    "#.##########.##.##########.#",
+    "#.##########.##.##########.#",
+    "#..........................#",
+    "############################",
+    "                            ",
+    "                            "
+  };
+  return level;
+}
@@ -0,0 +1,269 @@
+#include "dot_renderer.h"
+#include <algorithm>
+#include <vector>
+#include "raymath.h"
+#include "rlgl.h"
+#include "bits.h"
+
+static constexpr float DOT_RADIUS = 3.0f;
+static constexpr float PILL_RADIUS = 8.0f;
+
+// Corners are in radius units, the quad has a pixel of margin for the
+// antialiased edge
+static const char* DOT_VERTEX_SHADER = R"(#version 330
+in vec2 vertexPosition;
+in vec3 instanceDot;
+in float instanceAlive;
+uniform mat4 mvp;
+out vec2 fragLocal;
+out float fragRadius;
+void main() {
+  fragRadius = instanceDot.z * instanceAlive;
+  fragLocal = vertexPosition * (fragRadius + 1.0);
+  gl_Position = mvp * vec4(instanceDot.xy + fragLocal, 0.0, 1.0);
+}
+)";
+
+static const char* DOT_FRAGMENT_SHADER = R"(#version 330
+in vec2 fragLocal;
+in float fragRadius;
+uniform vec4 dotColor;
+out vec4 finalColor;
+void main() {
+  float alpha = clamp(fragRadius - length(fragLocal) + 0.5, 0.0, 1.0);
+  if (alpha <= 0.0) discard;
+  finalColor = vec4(dotColor.rgb, dotColor.a * alpha);
+}
+)";
+
+bool is_dot_renderer_supported() {
+  const int version = rlGetVersion();
+  return version == RL_OPENGL_33 || version == RL_OPENGL_43;
+}
+
+// Instances of the tiles in [start, end) of a row, in front of end
+static std::uint32_t count_slots(const std::uint64_t* row, std::uint32_t start, std::uint32_t end) {
+  std::uint32_t count = 0;
+  for (std::uint32_t word = start >> 6; start < end && word <= (end - 1) >> 6; ++word) {
+    count += popcount64(row[word] & get_span_mask(word, start, end));
+  }
+  return count;
+}
+
+bool build_dot_renderer(DotRenderer* renderer, const TileMap& tile_map, std::uint16_t chunk_tiles) {
+  unload_dot_renderer(renderer);
+  if (!is_dot_renderer_supported() || chunk_tiles == 0) return false;
+
+  const std::size_t layer_words = tile_map.layer_words();
+  const std::uint16_t words_per_row = tile_map.words_per_row;
+  const std::uint64_t* dots = tile_map.layer_row(TILE_TYPE::DOT, 0);
+  const std::uint64_t* pills = tile_map.layer_row(TILE_TYPE::PILL, 0);
+  const float tile_size = static_cast<float>(tile_map.tile_size);
+  const std::uint16_t chunk_cols = static_cast<std::uint16_t>((tile_map.cols + chunk_tiles - 1) / chunk_tiles);
+  const std::uint16_t chunk_rows = static_cast<std::uint16_t>((tile_map.rows + chunk_tiles - 1) / chunk_tiles);
+
+  renderer->layer_words = layer_words;
+  renderer->chunk_tiles = chunk_tiles;
+  renderer->chunk_cols = chunk_cols;
+  renderer->chunk_rows = chunk_rows;
+  renderer->chunk_first = std::make_unique<std::uint32_t[]>(std::size_t(chunk_cols) * chunk_rows + 1);
+  renderer->segment_first = std::make_unique<std::uint32_t[]>(std::size_t(tile_map.rows) * chunk_cols);
+  renderer->slots = std::make_unique<std::uint64_t[]>(layer_words);
+  renderer->drawn = std::make_unique<std::uint64_t[]>(layer_words);
+  for (std::size_t i = 0; i < layer_words; ++i) {
+    renderer->slots[i] = dots[i] | pills[i];
+    renderer->drawn[i] = renderer->slots[i];
+  }
+
+  std::vector<float> instances;
+  std::uint32_t num_instances = 0;
+  for (std::uint32_t chunk_row = 0; chunk_row < chunk_rows; ++chunk_row) {
+    const std::uint32_t first_row = chunk_row * chunk_tiles;
+    const std::uint32_t end_row = std::min<std::uint32_t>(first_row + chunk_tiles, tile_map.rows);
+
+    for (std::uint32_t chunk_col = 0; chunk_col < chunk_cols; ++chunk_col) {
+      const std::uint32_t first_col = chunk_col * chunk_tiles;
+      const std::uint32_t end_col = std::min<std::uint32_t>(first_col + chunk_tiles, tile_map.cols);
+      renderer->chunk_first[chunk_row * chunk_cols + chunk_col] = num_instances;
+
+      for (std::uint32_t row = first_row; row < end_row; ++row) {
+        renderer->segment_first[row * chunk_cols + chunk_col] = num_instances;
+        const std::size_t row_word = std::size_t(row) * words_per_row;
+
+        for (std::uint32_t word = first_col >> 6; word <= (end_col - 1) >> 6; ++word) {
+          const std::uint64_t slots = renderer->slots[row_word + word] & get_span_mask(word, first_col, end_col);
+          for (std::uint64_t bits = slots; bits; bits &= bits - 1) {
+            const std::uint32_t bit = ctz64(bits);
+            instances.push_back((static_cast<float>(word * 64u + bit) + 0.5f) * tile_size);
+            instances.push_back((static_cast<float>(row) + 0.5f) * tile_size);
+            instances.push_back(((pills[row_word + word] >> bit) & 1u) ? PILL_RADIUS : DOT_RADIUS);
+          }
+          num_instances += popcount64(slots);
+        }
+      }
+    }
+  }
+  renderer->chunk_first[std::size_t(chunk_cols) * chunk_rows] = num_instances;
+  renderer->num_instances = num_instances;
+  renderer->alive = std::make_unique<float[]>(num_instances);
+  std::fill(renderer->alive.get(), renderer->alive.get() + num_instances, 1.0f);
+
+  Shader& shader = renderer->shader;
+  shader = LoadShaderFromMemory(DOT_VERTEX_SHADER, DOT_FRAGMENT_SHADER);
+  renderer->mvp_loc = GetShaderLocation(shader, "mvp");
+  renderer->color_loc = GetShaderLocation(shader, "dotColor");
+  const int position_loc = shader.locs[SHADER_LOC_VERTEX_POSITION];
+  const int dot_loc = GetShaderLocationAttrib(shader, "instanceDot");
+  const int alive_loc = GetShaderLocationAttrib(shader, "instanceAlive");
+  renderer->dot_loc = dot_loc;
+  renderer->alive_loc = alive_loc;
+
+  // raylib falls back to its default shader when ours doesn't compile
+  if (shader.id == rlGetShaderIdDefault() || position_loc < 0 || dot_loc < 0 || alive_loc < 0) {
+    if (shader.id != rlGetShaderIdDefault()) UnloadShader(shader);
+    shader = Shader{};
+    renderer->num_instances = 0;
+    return false;
+  }
+
+  // Two triangles of the unit quad
+  static const float quad[12] = { -1.0f, -1.0f,  1.0f, -1.0f,  1.0f, 1.0f,
+                                  -1.0f, -1.0f,  1.0f,  1.0f, -1.0f, 1.0f };
+
+  renderer->vao = rlLoadVertexArray();
+  rlEnableVertexArray(renderer->vao);
+
+  renderer->quad_vbo = rlLoadVertexBuffer(quad, sizeof(quad), false);
+  rlSetVertexAttribute(static_cast<unsigned int>(position_loc), 2, RL_FLOAT, false, 0, 0);
+  rlEnableVertexAttribute(static_cast<unsigned int>(position_loc));
+
+  renderer->instance_vbo = rlLoadVertexBuffer(instances.data(),
+                                              static_cast<int>(instances.size() * sizeof(float)), false);
+  rlSetVertexAttribute(static_cast<unsigned int>(dot_loc), 3, RL_FLOAT, false, 0, 0);
+  rlEnableVertexAttribute(static_cast<unsigned int>(dot_loc));
+  rlSetVertexAttributeDivisor(static_cast<unsigned int>(dot_loc), 1);
+
+  renderer->alive_vbo = rlLoadVertexBuffer(renderer->alive.get(),
+                                           static_cast<int>(num_instances * sizeof(float)), true);
+  rlSetVertexAttribute(static_cast<unsigned int>(alive_loc), 1, RL_FLOAT, false, 0, 0);
+  rlEnableVertexAttribute(static_cast<unsigned int>(alive_loc));
+  rlSetVertexAttributeDivisor(static_cast<unsigned int>(alive_loc), 1);
+
+  rlDisableVertexArray();
+  rlDisableVertexBuffer();
+  return true;
+}
+
+bool sync_dot_renderer(DotRenderer* renderer, const TileMap& tile_map, const TileRect& chunks) {
+  if (renderer->layer_words != tile_map.layer_words()) return false;
+
+  const std::uint16_t words_per_row = tile_map.words_per_row;
+  const std::uint32_t chunk_tiles = renderer->chunk_tiles;
+  const std::uint64_t* dots = tile_map.layer_row(TILE_TYPE::DOT, 0);
+  const std::uint64_t* pills = tile_map.layer_row(TILE_TYPE::PILL, 0);
+
+  const std::uint32_t first_col = chunks.col * chunk_tiles;
+  const std::uint32_t end_col = std::min<std::uint32_t>((chunks.col + chunks.width) * chunk_tiles, tile_map.cols);
+  const std::uint32_t first_row = chunks.row * chunk_tiles;
+  const std::uint32_t end_row = std::min<std::uint32_t>((chunks.row + chunks.height) * chunk_tiles, tile_map.rows);
+  if (first_col >= end_col || first_row >= end_row) return true;
+
+  // Changed instances are uploaded as one range
+  std::uint32_t first_changed = renderer->num_instances;
+  std::uint32_t last_changed = 0;
+  for (std::uint32_t row = first_row; row < end_row; ++row) {
+    const std::size_t row_word = std::size_t(row) * words_per_row;
+    const std::uint64_t* slots = &renderer->slots[row_word];
+
+    for (std::uint32_t word = first_col >> 6; word <= (end_col - 1) >> 6; ++word) {
+      const std::size_t i = row_word + word;
+      const std::uint64_t mask = get_span_mask(word, first_col, end_col);
+      const std::uint64_t items = (dots[i] | pills[i]) & mask;
+      if (items & ~renderer->slots[i]) return false;
+
+      std::uint64_t changed = (items ^ renderer->drawn[i]) & mask;
+      for (; changed; changed &= changed - 1) {
+        const std::uint32_t bit = ctz64(changed);
+        const std::uint32_t col = word * 64u + bit;
+        const std::uint32_t chunk_col = col / chunk_tiles;
+        const std::uint32_t instance = renderer->segment_first[row * renderer->chunk_cols + chunk_col] +
+                                       count_slots(slots, chunk_col * chunk_tiles, col);
+        renderer->alive[instance] = ((items >> bit) & 1u) ? 1.0f : 0.0f;
+        first_changed = std::min(first_changed, instance);
+        last_changed = std::max(last_changed, instance);
+      }
+      renderer->drawn[i] = (renderer->drawn[i] & ~mask) | items;
+    }
+  }
+
+  if (first_changed <= last_changed) {
+    rlUpdateVertexBuffer(renderer->alive_vbo, &renderer->alive[first_changed],
+                         static_cast<int>((last_changed - first_changed + 1) * sizeof(float)),
+                         static_cast<int>(first_changed * sizeof(float)));
+  }
+  return true;
+}
+
+// Points the instance attributes at first, there's no base instance in
+// OpenGL 3.3
+static void draw_instance_range(const DotRenderer& renderer, std::uint32_t first, std::uint32_t end) {
+  if (first >= end) return;
+
+  rlEnableVertexBuffer(renderer.instance_vbo);
+  rlSetVertexAttribute(static_cast<unsigned int>(renderer.dot_loc), 3, RL_FLOAT, false, 0,
+                       static_cast<int>(first * 3 * sizeof(float)));
+  rlEnableVertexBuffer(renderer.alive_vbo);
+  rlSetVertexAttribute(static_cast<unsigned int>(renderer.alive_loc), 1, RL_FLOAT, false, 0,
+                       static_cast<int>(first * sizeof(float)));
+  rlDrawVertexArrayInstanced(0, 6, static_cast<int>(end - first));
+}
+
+void draw_dot_renderer(const DotRenderer& renderer, Color color, const TileRect& chunks) {
+  if (renderer.num_instances == 0 || chunks.width == 0 || chunks.height == 0) return;
+
+  // Whatever raylib has batched so far goes first, it's drawn underneath
+  rlDrawRenderBatchActive();
+
+  const Matrix mvp = MatrixMultiply(rlGetMatrixModelview(), rlGetMatrixProjection());
+  const Vector4 dot_color = ColorNormalize(color);
+
+  rlEnableShader(renderer.shader.id);
+  rlSetUniformMatrix(renderer.mvp_loc, mvp);
+  rlSetUniform(renderer.color_loc, &dot_color, RL_SHADER_UNIFORM_VEC4, 1);
+  rlEnableVertexArray(renderer.vao);
+
+  // Chunk rows that follow each other in the instance buffer (whole rows of
+  // the map) go in the same call
+  std::uint32_t run_first = 0;
+  std::uint32_t run_end = 0;
+  for (std::uint32_t chunk_row = chunks.row; chunk_row < std::uint32_t(chunks.row) + chunks.height; ++chunk_row) {
+    const std::size_t chunk = std::size_t(chunk_row) * renderer.chunk_cols + chunks.col;
+    const std::uint32_t first = renderer.chunk_first[chunk];
+    const std::uint32_t end = renderer.chunk_first[chunk + chunks.width];
+    if (first != run_end) {
+      draw_instance_range(renderer, run_first, run_end);
+      run_first = first;
+    }
+    run_end = end;
+  }
+  draw_instance_range(renderer, run_first, run_end);
+
+  rlDisableVertexArray();
+  rlDisableVertexBuffer();
+  rlDisableShader();
+}
+
+void unload_dot_renderer(DotRenderer* renderer) {
+  if (renderer->vao != 0) {
+    rlUnloadVertexArray(renderer->vao);
+    rlUnloadVertexBuffer(renderer->quad_vbo);
+    rlUnloadVertexBuffer(renderer->instance_vbo);
+    rlUnloadVertexBuffer(renderer->alive_vbo);
+    UnloadShader(renderer->shader);
+  }
+  renderer->shader = Shader{};
+  renderer->vao = 0;
+  renderer->num_instances = 0;
+  renderer->layer_words = 0;
+  renderer->chunk_tiles = 0;
+}
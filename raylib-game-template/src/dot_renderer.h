@@ -0,0 +1,56 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include "raylib.h"
+#include "tile_map.h"
+#include "wall_mesh.h"
+
+// Draws every dot and pill of a map with a single instanced draw call. Each
+// one is a quad shaded as a circle by its signed distance, so there's no
+// per-dot geometry or trig on the CPU. Positions are uploaded once when
+// built, afterwards only a per-instance alive flag changes as dots get
+// eaten (or come back with a new game).
+//
+// Instances are ordered by square chunks of the map, row-major, so the
+// chunks of a view are one instance range per chunk row: a view of a big
+// maze draws and syncs only its own dots.
+//
+// Needs OpenGL 3.3 for instancing, see is_dot_renderer_supported().
+struct DotRenderer {
+  Shader shader{};
+  int mvp_loc{-1};
+  int color_loc{-1};
+  unsigned int vao{0};
+  unsigned int quad_vbo{0};
+  unsigned int instance_vbo{0};              // center x/y and radius, static
+  unsigned int alive_vbo{0};                 // 1.0 or 0.0, updated on changes
+  int dot_loc{-1};
+  int alive_loc{-1};
+  std::uint32_t num_instances{0};
+  std::size_t layer_words{0};
+  std::uint16_t chunk_tiles{0};
+  std::uint16_t chunk_cols{0};
+  std::uint16_t chunk_rows{0};
+  std::unique_ptr<std::uint32_t[]> chunk_first;    // first instance of each chunk, and the total
+  std::unique_ptr<std::uint32_t[]> segment_first;  // first instance of each row of each chunk
+  std::unique_ptr<std::uint64_t[]> slots;          // tiles that have an instance
+  std::unique_ptr<std::uint64_t[]> drawn;          // dot/pill bits last uploaded
+  std::unique_ptr<float[]> alive;                  // CPU copy of alive_vbo
+};
+
+bool is_dot_renderer_supported();
+
+// One instance per dot/pill currently on the map, grouped by chunks of
+// chunk_tiles. Returns false if instancing isn't supported.
+bool build_dot_renderer(DotRenderer* renderer, const TileMap& tile_map, std::uint16_t chunk_tiles);
+
+// Uploads the alive flags of tiles in the given chunks (see TileRect) whose
+// dot/pill changed, chunks elsewhere catch up once they're synced. Returns
+// false if a dot/pill showed up on a tile without an instance, build again
+// then.
+bool sync_dot_renderer(DotRenderer* renderer, const TileMap& tile_map, const TileRect& chunks);
+
+// Draws the dots/pills of the given chunks, a draw call per chunk row
+// unless they're whole rows of the map
+void draw_dot_renderer(const DotRenderer& renderer, Color color, const TileRect& chunks);
+void unload_dot_renderer(DotRenderer* renderer);
@@ -1,97 +1,45 @@
 #include "entity.h"
-#include "raylib.h"
-#include "raymath.h"
 
-void init_entity(Entity* entity, const Vector2& tile_pos,
-                 const char* texture_path, float movement_speed) {
-  entity->tile_pos = tile_pos;
-  entity->prev_tile_pos = tile_pos;
-  entity->tile_step_time = movement_speed;
-
-  entity->texture = LoadTexture(texture_path);
-
-  // setup animation context
-  entity->anim_ctx.frame_rec = {
-    0.0f,
-    0.0f,
-    static_cast<float>(entity->texture.width / 8),
-    static_cast<float>(entity->texture.height)
-  };
-  entity->anim_ctx.current_frame = 0;
-  entity->anim_ctx.frames_speed = 8; // 8 fps or 8 frames per sheet
-}
-
-void render_entity(const TileMap& tile_map, Entity* entity, Color tint, float dt) {
-  const Texture2D player_texture = entity->texture;
-  const float tile_size = static_cast<float>(tile_map.tile_size);
-
-  float alpha = Clamp(entity->move_timer / entity->tile_step_time, 0.0f, 1.0f);
-  Vector2 interp_tile = {
-    Lerp(entity->prev_tile_pos.x, entity->tile_pos.x, alpha),
-    Lerp(entity->prev_tile_pos.y, entity->tile_pos.y, alpha)
-  };
-
-  // Calculate the new interpolated position and center it
-  Vector2 player_pos = {
-    interp_tile.x * tile_size + (tile_size / 2),
-    interp_tile.y * tile_size + (tile_size / 2)
-  };
-  
-  const float frame_duration = 1.0f / static_cast<float>(entity->anim_ctx.frames_speed);
-
-  // Accumulate elapsed time
-  entity->anim_ctx.time_accum += dt;
-
-  while (entity->anim_ctx.time_accum >= frame_duration) {
-    entity->anim_ctx.time_accum -= frame_duration;
-
-    // Advance to next frame
-    ++entity->anim_ctx.current_frame;
-    if (entity->anim_ctx.current_frame > 5) {
-      entity->anim_ctx.current_frame = 0;
-    }
-
-    entity->anim_ctx.frame_rec.x = static_cast<float>(entity->anim_ctx.current_frame) *
-      static_cast<float>(player_texture.width / 8);
-  }
-
-  Rectangle src = entity->anim_ctx.frame_rec;
-  const float frame_w = std::fabsf(src.width);
-  const float frame_h = src.height;
-
-  // NOTE: corner case, mirror flip (right -> left) the source rect if scale.x is negative
-  if (entity->scale.y < 0.0f) {
-    src.x += frame_w;   // shift to the right edge of the frame
-    src.width = -frame_w;
-  } else {
-    src.width = frame_w;
+EntityId find_ghost(const EntityStore& entities, GHOST_TYPE type) {
+  for (EntityId id = PLAYER_ID + 1; id < entities.count; ++id) {
+    if (entities.ghost_type[id] == type) return id;
   }
+  return NO_ENTITY;
+}
 
-  const float draw_w = frame_w * std::fabsf(entity->scale.x);
-  const float draw_h = frame_h * std::fabsf(entity->scale.y);
- 
-  Rectangle dst = {
-    player_pos.x,  // tile center X
-    player_pos.y,  // tile center Y
-    draw_w,
-    draw_h
-  };
+void init_entity(EntityStore* entities, EntityId id, TilePos tile_pos, float movement_speed) {
+  entities->tile_pos[id] = tile_pos;
+  entities->prev_tile_pos[id] = tile_pos;
+  entities->dir[id] = MOVEMENT_DIR::STOPPED;
+  entities->next_dir[id] = MOVEMENT_DIR::STOPPED;
+  entities->move_timer[id] = 0.0f;
+  entities->tile_step_time[id] = movement_speed;
+  entities->is_dead[id] = false;
+  entities->ghost_type[id] = GHOST_TYPE::NONE;
+  entities->in_monster_pen[id] = false;
+  entities->last_seen_change_seq[id] = 0;
+}
 
-  // Origin inside destination rect (0,0 = top-left; to center use half size)
-  Vector2 origin = { draw_w * 0.5f, draw_h * 0.5f  };
+EntityId add_ghost(EntityStore* entities, GHOST_TYPE type, TilePos tile_pos, float movement_speed) {
+  if (entities->count >= MAX_ENTITIES) return NO_ENTITY;
 
-  DrawTexturePro(player_texture, src, dst, origin, entity->rotation, tint);
+  const EntityId id = entities->count++;
+  init_entity(entities, id, tile_pos, movement_speed);
+  entities->ghost_type[id] = type;
+  entities->in_monster_pen[id] = true;
+  return id;
 }
 
-void handle_entity_on_teleport_tile(Entity* entity,
+void handle_entity_on_teleport_tile(EntityStore* entities, EntityId id,
                                     std::uint16_t num_tile_map_cols) {
-  if (entity->tile_pos.x == 0.0f) {
+  TilePos& tile_pos = entities->tile_pos[id];
+  if (tile_pos.col == 0) {
     // leftmost tile, send to rightmost tile
-    entity->tile_pos.x = num_tile_map_cols - 2.0f;
-    entity->prev_tile_pos.x = entity->tile_pos.x;
-  } else if (entity->tile_pos.x == static_cast<float>(num_tile_map_cols) - 1.0f) {
+    tile_pos.col = static_cast<std::int16_t>(num_tile_map_cols - 2);
+    entities->prev_tile_pos[id].col = tile_pos.col;
+  } else if (tile_pos.col == num_tile_map_cols - 1) {
     // rightmost tile, send to leftmost tile
-    entity->tile_pos.x = 1.0f;
-    entity->prev_tile_pos.x = entity->tile_pos.x;
+    tile_pos.col = 1;
+    entities->prev_tile_pos[id].col = tile_pos.col;
   }
 }
@@ -1,55 +1,68 @@
 #pragma once
 #include <cstdint>
-#include "raylib.h"
 #include "timer.h"
 #include "movement_dir.h"
 #include "tile_map.h"
 
-struct EntityAnimationContext {
-  Rectangle frame_rec;
-  std::uint32_t current_frame;
-  float time_accum = 0.0f;
-  std::uint32_t frames_speed;        // frames per second
+enum class GHOST_TYPE : std::uint8_t {
+    NONE = 0,
+    BLINKY,
+    PINKY,
+    INKY,
+    CLYDE,
 };
 
-// Fat entity struct
-struct Entity {
-  Vector2 tile_pos{};
-  Vector2 prev_tile_pos{};
-  MOVEMENT_DIR dir{MOVEMENT_DIR::STOPPED};
-  MOVEMENT_DIR next_dir{MOVEMENT_DIR::STOPPED};
-  float move_timer{0.0f};
-  float tile_step_time{0.0f};
+using EntityId = std::uint16_t;
 
-  // Rendering
-  Texture2D texture{};
-  Vector2 scale{1.5f, 1.5f};
-  float rotation{0.0f};
-  EntityAnimationContext anim_ctx{};
+// Fixed capacity keeps the store a single flat block, the player and
+// up to 31 ghosts
+constexpr std::uint16_t MAX_ENTITIES = 32;
+constexpr EntityId PLAYER_ID = 0;
+constexpr EntityId NO_ENTITY = 0xffff;
 
-  // Gameplay flags
-  bool is_dead{false};
+// Structure of arrays entity storage, indexed by EntityId. The player
+// always sits at PLAYER_ID, ghosts take the ids after it. Rendering state
+// (textures, animations) lives apart from this, see render.h.
+struct EntityStore {
+  std::uint16_t count{1};
+
+  // Movement, shared by the player and the ghosts
+  TilePos tile_pos[MAX_ENTITIES]{};
+  TilePos prev_tile_pos[MAX_ENTITIES]{};
+  MOVEMENT_DIR dir[MAX_ENTITIES]{};
+  MOVEMENT_DIR next_dir[MAX_ENTITIES]{};
+  float move_timer[MAX_ENTITIES]{};
+  float tile_step_time[MAX_ENTITIES]{};
+  bool is_dead[MAX_ENTITIES]{};
+
+  // Ghost gameplay specific, unused for the player
+  GHOST_TYPE ghost_type[MAX_ENTITIES]{};
+  bool in_monster_pen[MAX_ENTITIES]{};
+  std::uint16_t last_seen_change_seq[MAX_ENTITIES]{};
 
   // Player gameplay specific
-  std::uint16_t collected_dots{0};
+  std::uint32_t collected_dots{0};
   bool is_energized{false};
   Timer energized_timer{};
 
-  // Ghost gameplay specific
-  bool in_monster_pen{true};
-  std::uint32_t last_seen_change_seq{0};
+  std::uint16_t num_ghosts() const { return static_cast<std::uint16_t>(count - 1); }
 };
 
-inline bool entity_collision(const Entity& a, const Entity& b) {
-  return a.tile_pos.x == b.tile_pos.x && a.tile_pos.y == b.tile_pos.y;
+inline bool entity_collision(const EntityStore& entities, EntityId a, EntityId b) {
+  return entities.tile_pos[a] == entities.tile_pos[b];
 }
 
-inline Vector2 get_tile_pos_ahead_of_entity(const Entity& entity, int tiles) {
-  Vector2 delta = get_step_delta(entity.dir);
-  return { entity.tile_pos.x + delta.x * tiles, entity.tile_pos.y + delta.y * tiles };
+inline TilePos get_tile_pos_ahead_of_entity(const EntityStore& entities, EntityId id, int tiles) {
+  return entities.tile_pos[id] + get_step_delta(entities.dir[id]) * tiles;
 }
 
-void init_entity(Entity* player, const Vector2& tile_pos,
-                 const char* texture_path, float movement_speed);
-void render_entity(const TileMap& tile_map, Entity* entity, Color tint, float dt);
-void handle_entity_on_teleport_tile(Entity* entity, std::uint16_t num_tile_map_cols);
+// First ghost of the given type, NO_ENTITY if the maze has none
+EntityId find_ghost(const EntityStore& entities, GHOST_TYPE type);
+
+// Gameplay only init, textures are loaded separately (see render.h) so the
+// simulation can run without a window/GL context
+void init_entity(EntityStore* entities, EntityId id, TilePos tile_pos, float movement_speed);
+// Returns NO_ENTITY once the store is full
+EntityId add_ghost(EntityStore* entities, GHOST_TYPE type, TilePos tile_pos, float movement_speed);
+void handle_entity_on_teleport_tile(EntityStore* entities, EntityId id,
+                                    std::uint16_t num_tile_map_cols);
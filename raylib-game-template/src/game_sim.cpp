@@ -0,0 +1,100 @@
+#include "game_sim.h"
+
+static bool init_game_sim(GameSim* sim, const TileMap& level_map, const EntityStore& level_entities,
+                          const GameSimConfig& config, bool share_layout) {
+  sim->config = config;
+  sim->source = nullptr;
+  sim->distance_fields.shared = nullptr;
+  if (share_layout) {
+    sim->tile_map.view_of(level_map);
+  } else {
+    sim->tile_map.copy_from(level_map);
+  }
+  if (!init_game_state(&sim->initial_state, level_map, level_entities, &sim->initial_layers)) return false;
+
+  // Everything step() reads is built up front, except the distance fields
+  // of big levels: building all of them is quadratic in the maze size, so
+  // ghosts build the ones they ask for instead
+  sync_tile_exit_masks(&sim->exit_masks, sim->tile_map);
+  if (config.shortest_path_ghosts) {
+    sync_distance_fields(&sim->distance_fields, sim->tile_map);
+    if (sim->distance_fields.num_walkable <= MAX_EAGER_DISTANCE_FIELD_TILES) {
+      build_all_distance_fields(&sim->distance_fields, sim->tile_map);
+    }
+  }
+
+  init_zobrist_keys(&sim->zobrist, sim->tile_map);
+  GameState& initial_state = sim->initial_state;
+  sim->bind(&initial_state, &sim->initial_layers);
+  initial_state.hash = compute_zobrist_hash(sim->zobrist, sim->tile_map,
+                                            initial_state.entities, initial_state.ghosts_sm);
+  return true;
+}
+
+bool init_game_sim(GameSim* sim, const TileMap& level_map, const EntityStore& level_entities,
+                   const GameSimConfig& config) {
+  return init_game_sim(sim, level_map, level_entities, config, false);
+}
+
+bool init_game_sim_shared(GameSim* sim, const TileMap& level_map, const EntityStore& level_entities,
+                          const GameSimConfig& config) {
+  return init_game_sim(sim, level_map, level_entities, config, true);
+}
+
+void init_game_sim_from(GameSim* sim, const GameSim& source) {
+  sim->config = source.config;
+  sim->tile_map.view_of(source.tile_map);
+  sim->source = &source;
+  snapshot_game_state(source.initial_state, &sim->initial_state);
+  copy_game_layers(source.initial_layers, &sim->initial_layers);
+
+  // An incomplete cache is written by every lookup, each GameSim then
+  // builds the fields it needs itself
+  sim->distance_fields = DistanceFieldCache{};
+  if (source.distance_fields.complete) sim->distance_fields.shared = &source.distance_fields;
+}
+
+void GameSim::reset(GameState* state, std::uint64_t seed, std::uint64_t stream, GameLayers* layers) {
+  snapshot_game_state(initial_state, state);
+  if (needs_layers()) copy_game_layers(initial_layers, layers);
+  seed_sim_random(&state->random, seed, stream);
+}
+
+StepResult GameSim::step(GameState* state, MOVEMENT_DIR action, float dt, GameLayers* layers) {
+  EntityStore& entities = state->entities;
+  bind(state, layers);
+
+  StepResult result = {};
+  result.status = get_game_status(tile_map, entities);
+  if (result.status != GAME_STATUS::PLAYING) return result;
+
+  if (action != MOVEMENT_DIR::STOPPED) entities.next_dir[PLAYER_ID] = action;
+
+  const GameSim& level = source ? *source : *this;
+
+  const GhostContext ghost_ctx{
+    tile_map,
+    state->ghosts_sm,
+    entities,
+    find_ghost(entities, GHOST_TYPE::BLINKY),
+    config.pen_door,
+    config.pen_home,
+    &state->random,
+    config.shortest_path_ghosts ? &distance_fields : nullptr,
+    &level.exit_masks,
+    profiler
+  };
+
+  result.events = step_game(&tile_map, &entities, &state->ghosts_sm, ghost_ctx,
+                            config.scatter_schedule, config.chase_schedule, dt,
+                            &level.zobrist, &state->hash);
+  result.status = get_game_status(tile_map, entities);
+
+  const StepEvents& events = result.events;
+  result.reward = events.dots_eaten * config.dot_reward +
+                  events.pills_eaten * config.pill_reward +
+                  events.ghosts_eaten * config.ghost_reward;
+  if (events.player_died) result.reward += config.death_reward;
+  if (result.status == GAME_STATUS::WON) result.reward += config.win_reward;
+  return result;
+}
@@ -0,0 +1,98 @@
+#pragma once
+#include <cstdint>
+#include "tile_map.h"
+#include "entity.h"
+#include "movement_dir.h"
+#include "ghosts.h"
+#include "tile_exit_masks.h"
+#include "nav.h"
+#include "sim.h"
+#include "zobrist.h"
+#include "classic_level.h"
+#include "game_state.h"
+#include "profiler.h"
+
+// Forward model of a level for lookahead agents: step() advances a caller
+// owned GameState by one tick and reports what happened. Stepping doesn't
+// allocate (see MAX_EAGER_DISTANCE_FIELD_TILES for the one exception),
+// touch raylib or any global state, so a planner can snapshot a
+// state (see snapshot_game_state()) and roll it forward as often as it
+// likes. On levels too big for a GameState the dots/pills are snapshot on
+// their own (see copy_game_layers()).
+//
+// A GameSim holds the level's fixed data (walls, navigation, hash keys) and
+// a map whose DOT/PILL layers get pointed at the state being stepped. Any
+// number of states can go through one GameSim, but it's not meant to be
+// shared between threads, give each thread its own. Those can read one
+// GameSim's fixed data instead of building their own, see
+// init_game_sim_from().
+
+// Levels with more walkable tiles than this build their distance fields
+// lazily (see init_game_sim()), their first steps with shortest_path_ghosts
+// then allocate until the cache is full
+constexpr std::uint32_t MAX_EAGER_DISTANCE_FIELD_TILES = 4096;
+
+struct GameSimConfig {
+  float dot_reward{1.0f};
+  float pill_reward{5.0f};
+  float ghost_reward{20.0f};
+  float win_reward{100.0f};
+  float death_reward{-100.0f};
+  TilePos pen_door{CLASSIC_PEN_DOOR};
+  TilePos pen_home{CLASSIC_PEN_HOME};
+  const double* scatter_schedule{CLASSIC_SCATTER_SCHEDULE};
+  const double* chase_schedule{CLASSIC_CHASE_SCHEDULE};
+  bool shortest_path_ghosts{false};         // see DistanceFieldCache
+};
+
+struct StepResult {
+  StepEvents events{};
+  GAME_STATUS status{GAME_STATUS::PLAYING}; // after the step
+  float reward{0.0f};                       // events weighted by the config, win included
+};
+
+struct GameSim {
+  GameSimConfig config{};
+  TileMap tile_map{};
+  TileExitMasks exit_masks{};
+  DistanceFieldCache distance_fields{};
+  ZobristKeys zobrist{};
+  GameState initial_state{};                // hash set, generator not seeded
+  GameLayers initial_layers{};              // dots/pills of levels too big for initial_state
+  const GameSim* source{nullptr};           // whose exit masks/hash keys are used, see init_game_sim_from()
+  FrameProfiler* profiler{nullptr};         // optional, see profiler.h
+
+  // Levels that don't fit a GameState inline (see fits_game_state_inline())
+  // keep each game's dots/pills in a GameLayers, which has to be passed
+  // along with the state to every call below. It's ignored otherwise.
+  bool needs_layers() const { return !initial_layers.words.empty(); }
+
+  // Puts *state at the start of the level, drawing from the given stream of seed
+  void reset(GameState* state, std::uint64_t seed, std::uint64_t stream = 0,
+             GameLayers* layers = nullptr);
+
+  // Advances *state by dt, which should be SIM_TICK_DT. action becomes the
+  // player's queued direction, STOPPED keeps the queued one. Finished games
+  // aren't stepped any further. state->hash is kept up to date.
+  StepResult step(GameState* state, MOVEMENT_DIR action, float dt = SIM_TICK_DT,
+                  GameLayers* layers = nullptr);
+
+  // Points tile_map at *state, e.g. to look at it through the TileMap API
+  void bind(GameState* state, GameLayers* layers = nullptr) { bind_game_state(&tile_map, state, layers); }
+};
+
+// Takes a parsed level (see parse_level()) as the starting point of every
+// game. Returns false if the level doesn't fit in a GameState.
+bool init_game_sim(GameSim* sim, const TileMap& level_map, const EntityStore& level_entities,
+                   const GameSimConfig& config);
+// Same, but the walls/doors/teleports stay in level_map's layers instead of
+// being copied, e.g. a compiled level's mapping (see load_level()). Only
+// the dots/pills are copied, into initial_state. level_map has to outlive
+// the GameSim and its layout can't change while the GameSim is in use.
+bool init_game_sim_shared(GameSim* sim, const TileMap& level_map, const EntityStore& level_entities,
+                          const GameSimConfig& config);
+// A GameSim playing source's level, reading source's exit masks, hash keys
+// and (if complete) distance fields instead of building its own, e.g. one
+// per worker thread. source is only read, so any number of threads can
+// share it, but it has to outlive them and can't be stepped meanwhile.
+void init_game_sim_from(GameSim* sim, const GameSim& source);
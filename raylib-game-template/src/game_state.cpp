@@ -0,0 +1,39 @@
+#include "game_state.h"
+#include <algorithm>
+
+bool init_game_state(GameState* state, const TileMap& level_map,
+                     const EntityStore& level_entities, GameLayers* layers) {
+  if (!fits_game_state(level_map)) return false;
+  const bool inline_layers = fits_game_state_inline(level_map);
+  if (!inline_layers && !layers) return false;
+
+  const std::size_t layer_words = level_map.layer_words();
+  const std::uint64_t* dots = level_map.layer_row(TILE_TYPE::DOT, 0);
+  const std::uint64_t* pills = level_map.layer_row(TILE_TYPE::PILL, 0);
+  std::fill(std::begin(state->dots), std::end(state->dots), 0);
+  std::fill(std::begin(state->pills), std::end(state->pills), 0);
+  if (inline_layers) {
+    if (layers) layers->words.clear();
+    std::copy(dots, dots + layer_words, state->dots);
+    std::copy(pills, pills + layer_words, state->pills);
+  } else {
+    layers->words.assign(dots, dots + layer_words);
+    layers->words.insert(layers->words.end(), pills, pills + layer_words);
+  }
+
+  state->entities = level_entities;
+  state->ghosts_sm = GhostsStateMachine{};
+  state->hash = 0;
+  return true;
+}
+
+void bind_game_state(TileMap* tile_map, GameState* state, GameLayers* layers) {
+  if (fits_game_state_inline(*tile_map)) {
+    tile_map->bind_layer(TILE_TYPE::DOT, state->dots);
+    tile_map->bind_layer(TILE_TYPE::PILL, state->pills);
+    return;
+  }
+  std::uint64_t* words = layers->words.data();
+  tile_map->bind_layer(TILE_TYPE::DOT, words);
+  tile_map->bind_layer(TILE_TYPE::PILL, words + tile_map->layer_words());
+}
@@ -0,0 +1,82 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+#include "tile_map.h"
+#include "entity.h"
+#include "ghosts.h"
+#include "sim_random.h"
+
+// Fixed capacity of the dot/pill bitboards in a GameState: 64 rows of up
+// to 64 columns, the classic maze is 28x36. Bigger levels keep theirs in a
+// GameLayers next to the state.
+constexpr std::uint16_t MAX_GAME_STATE_ROWS = 64;
+constexpr std::uint16_t MAX_GAME_STATE_WORDS = MAX_GAME_STATE_ROWS;
+
+// Entities address tiles with TilePos, so that's as big as a game gets
+constexpr std::uint16_t MAX_GAME_STATE_SIZE = 0x7fff;
+
+// Everything that changes while a game is played, in one flat block: no
+// pointers, no GPU handles, no heap. Walls, doors and teleports never change
+// during a game, so they stay in the level's TileMap, which gets its
+// DOT/PILL layers pointed at a state with bind_game_state().
+//
+// Copying a GameState (snapshot_game_state()/restore_game_state()) is a
+// single memcpy, e.g. for tree search branching off a position.
+struct GameState {
+  std::uint64_t dots[MAX_GAME_STATE_WORDS];
+  std::uint64_t pills[MAX_GAME_STATE_WORDS];
+  EntityStore entities;
+  GhostsStateMachine ghosts_sm;
+  SimRandom random;
+  std::uint64_t hash;              // Zobrist hash, see zobrist.h
+};
+
+static_assert(std::is_trivially_copyable<GameState>::value,
+              "GameState has to be copyable with memcpy");
+static_assert(sizeof(GameState) <= 2048, "GameState should stay within 2 KB");
+
+// Dots/pills of a level too big for a GameState's bitboards, owned by the
+// caller and passed along with the state they belong to. Left empty for
+// levels that fit.
+struct GameLayers {
+  std::vector<std::uint64_t> words;        // dots then pills, layer_words() each
+};
+
+// Whether a map's dots/pills fit in a GameState, no GameLayers needed
+inline bool fits_game_state_inline(const TileMap& tile_map) {
+  return tile_map.layer_words() <= MAX_GAME_STATE_WORDS;
+}
+
+// Whether a game can be played on the map at all
+inline bool fits_game_state(const TileMap& tile_map) {
+  return tile_map.cols <= MAX_GAME_STATE_SIZE && tile_map.rows <= MAX_GAME_STATE_SIZE;
+}
+
+// Starts a game on the given level, the map's current dots/pills and the
+// entities are copied in. The generator is left alone, seed it with
+// seed_sim_random(). The hash is 0 until set with compute_zobrist_hash().
+// Returns false if the map is bigger than MAX_GAME_STATE_SIZE, or doesn't
+// fit inline and no layers were given.
+bool init_game_state(GameState* state, const TileMap& level_map,
+                     const EntityStore& level_entities, GameLayers* layers = nullptr);
+
+// Points tile_map's DOT/PILL layers at the state, or at layers if the map
+// doesn't fit inline. tile_map has to be the level (or a copy of it) the
+// state was made for.
+void bind_game_state(TileMap* tile_map, GameState* state, GameLayers* layers = nullptr);
+
+inline void snapshot_game_state(const GameState& state, GameState* snapshot) {
+  std::memcpy(snapshot, &state, sizeof(GameState));
+}
+
+inline void restore_game_state(GameState* state, const GameState& snapshot) {
+  std::memcpy(state, &snapshot, sizeof(GameState));
+}
+
+// A big level's dots/pills go with its snapshots, copied on their own. The
+// copy reuses the destination's storage once it has some.
+inline void copy_game_layers(const GameLayers& layers, GameLayers* copy) {
+  copy->words = layers.words;
+}
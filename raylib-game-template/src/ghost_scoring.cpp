@@ -0,0 +1,108 @@
+#include "ghost_scoring.h"
+#include <algorithm>
+
+#if !defined(GHOST_SCORING_NO_SIMD) && \
+    (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#include <emmintrin.h>
+#define GHOST_SCORING_SSE2 1
+#endif
+
+// Key layout: bit 30 set for non-walkable tiles, then the distance, then
+// the lane (priority) in the two low bits. Anything not a candidate gets
+// the largest key.
+static constexpr std::int32_t MAX_SCORING_DIST = (1 << 28) - 1;
+static constexpr std::int32_t NOT_WALKABLE_KEY = 1 << 30;
+static constexpr std::int32_t NOT_CANDIDATE_KEY = 0x7fffffff;
+
+// Keeps dx*dx + dy*dy within 32 bits in every path
+static constexpr std::int32_t MAX_SCORING_DELTA = 16383;
+
+static std::int32_t get_clamped_delta(std::int16_t from, std::int16_t to) {
+  return std::clamp(std::int32_t(from) - to, -MAX_SCORING_DELTA, MAX_SCORING_DELTA);
+}
+
+static MOVEMENT_DIR get_dir_from_key(std::int32_t key) {
+  if (key == NOT_CANDIDATE_KEY) return MOVEMENT_DIR::RIGHT;
+  return GHOST_SCORING_DIRS[key & 3];
+}
+
+static MOVEMENT_DIR score_scalar(const GhostScoringInput& input) {
+  const std::int32_t dx = get_clamped_delta(input.tile_pos.col, input.target.col);
+  const std::int32_t dy = get_clamped_delta(input.tile_pos.row, input.target.row);
+
+  std::int32_t best_key = NOT_CANDIDATE_KEY;
+  for (std::int32_t lane = 0; lane < 4; ++lane) {
+    if (!(input.candidate_mask & (1u << lane))) continue;
+
+    const TilePos delta = get_step_delta(GHOST_SCORING_DIRS[lane]);
+    const std::int32_t lane_dx = dx + delta.col;
+    const std::int32_t lane_dy = dy + delta.row;
+    const std::int32_t dist = std::min(lane_dx * lane_dx + lane_dy * lane_dy, MAX_SCORING_DIST);
+
+    std::int32_t key = (dist << 2) | lane;
+    if (!(input.walkable_mask & (1u << lane))) key += NOT_WALKABLE_KEY;
+    best_key = std::min(best_key, key);
+  }
+  return get_dir_from_key(best_key);
+}
+
+#if defined(GHOST_SCORING_SSE2)
+// Lane deltas of GHOST_SCORING_DIRS as (col, row) int16 pairs
+static __m128i get_lane_deltas_sse2() {
+  return _mm_setr_epi16(0, -1,  -1, 0,  0, 1,  1, 0);
+}
+
+static __m128i select_sse2(__m128i mask, __m128i a, __m128i b) {
+  return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+static __m128i min_epi32_sse2(__m128i a, __m128i b) {
+  return select_sse2(_mm_cmplt_epi32(a, b), a, b);
+}
+
+// Expands a 4 bit mask to all ones/zeros per 32-bit lane
+static __m128i expand_mask_sse2(std::uint8_t mask) {
+  const __m128i lane_bits = _mm_setr_epi32(1, 2, 4, 8);
+  return _mm_cmpeq_epi32(_mm_and_si128(_mm_set1_epi32(mask), lane_bits), lane_bits);
+}
+
+static MOVEMENT_DIR score_sse2(const GhostScoringInput& input) {
+  const std::int32_t dx = get_clamped_delta(input.tile_pos.col, input.target.col);
+  const std::int32_t dy = get_clamped_delta(input.tile_pos.row, input.target.row);
+
+  // (dx, dy) per lane, then dx*dx + dy*dy in one multiply-add
+  const __m128i base = _mm_set1_epi32(static_cast<std::int32_t>(
+    (std::uint32_t(std::uint16_t(dy)) << 16) | std::uint16_t(dx)));
+  const __m128i deltas = _mm_add_epi16(base, get_lane_deltas_sse2());
+  __m128i dist = _mm_madd_epi16(deltas, deltas);
+  const __m128i max_dist = _mm_set1_epi32(MAX_SCORING_DIST);
+  dist = min_epi32_sse2(dist, max_dist);
+
+  __m128i keys = _mm_or_si128(_mm_slli_epi32(dist, 2), _mm_setr_epi32(0, 1, 2, 3));
+  keys = _mm_add_epi32(keys, _mm_andnot_si128(expand_mask_sse2(input.walkable_mask),
+                                              _mm_set1_epi32(NOT_WALKABLE_KEY)));
+  keys = select_sse2(expand_mask_sse2(input.candidate_mask), keys,
+                     _mm_set1_epi32(NOT_CANDIDATE_KEY));
+
+  // Horizontal min over the 4 lanes
+  keys = min_epi32_sse2(keys, _mm_shuffle_epi32(keys, _MM_SHUFFLE(1, 0, 3, 2)));
+  keys = min_epi32_sse2(keys, _mm_shuffle_epi32(keys, _MM_SHUFFLE(2, 3, 0, 1)));
+  return get_dir_from_key(_mm_cvtsi128_si32(keys));
+}
+#endif
+
+void score_ghost_candidates(const GhostScoringInput* inputs, std::size_t count,
+                            MOVEMENT_DIR* out_dirs) {
+  for (std::size_t i = 0; i < count; ++i) {
+#if defined(GHOST_SCORING_SSE2)
+    out_dirs[i] = score_sse2(inputs[i]);
+#else
+    out_dirs[i] = score_scalar(inputs[i]);
+#endif
+  }
+}
+
+void score_ghost_candidates_scalar(const GhostScoringInput* inputs, std::size_t count,
+                                   MOVEMENT_DIR* out_dirs) {
+  for (std::size_t i = 0; i < count; ++i) out_dirs[i] = score_scalar(inputs[i]);
+}
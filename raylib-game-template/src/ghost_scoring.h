@@ -0,0 +1,38 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include "tile_pos.h"
+#include "movement_dir.h"
+
+// Straight line ghost decision kernel: scores the four neighbours of a ghost
+// against its target and picks the best one. Walkable tiles beat
+// non-walkable ones, then the smallest squared distance wins and ties go by
+// the arcade's UP, LEFT, DOWN, RIGHT priority. Each neighbour gets a single
+// integer key so the whole decision is a min over 4 lanes.
+//
+// Uses SSE2 when the compiler targets it, with a scalar fallback. Both
+// give the same results, "pacman_headless scoring" checks they agree.
+// Define GHOST_SCORING_NO_SIMD to build the scalar kernel only.
+
+// Lane order of the kernel, i.e. the tie-break priority
+constexpr MOVEMENT_DIR GHOST_SCORING_DIRS[4] = { MOVEMENT_DIR::UP, MOVEMENT_DIR::LEFT,
+                                                 MOVEMENT_DIR::DOWN, MOVEMENT_DIR::RIGHT };
+
+// Masks use bit i for GHOST_SCORING_DIRS[i]
+struct GhostScoringInput {
+  TilePos tile_pos;
+  TilePos target;
+  std::uint8_t candidate_mask;   // directions considered at all, e.g. not reversing
+  std::uint8_t walkable_mask;
+};
+
+// Picks a direction per input. Falls back to RIGHT when there are no
+// candidates, like the arcade does with a ghost stuck in place.
+// NOTE: distances are clamped so the keys can't overflow, which only makes
+// a difference for targets thousands of tiles away
+void score_ghost_candidates(const GhostScoringInput* inputs, std::size_t count,
+                            MOVEMENT_DIR* out_dirs);
+
+// Same, always with the scalar kernel, e.g. as the reference for the SIMD one
+void score_ghost_candidates_scalar(const GhostScoringInput* inputs, std::size_t count,
+                                   MOVEMENT_DIR* out_dirs);
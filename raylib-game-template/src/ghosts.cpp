@@ -1,16 +1,6 @@
 #include "ghosts.h"
 #include <algorithm>
-#include "raymath.h"
-
-static constexpr int prioritize_dir(MOVEMENT_DIR d) {
-  switch (d) {
-  case MOVEMENT_DIR::UP:    return 0;
-  case MOVEMENT_DIR::LEFT:  return 1;
-  case MOVEMENT_DIR::DOWN:  return 2;
-  case MOVEMENT_DIR::RIGHT: return 3;
-  default:                  return 4;
-  }
-}
+#include "ghost_scoring.h"
 
 static void start_scatter(GhostsStateMachine& sm, const double scatter_schedule[]) {
   sm.state = GHOST_STATE::SCATTER;
@@ -30,121 +20,183 @@ static void start_chase(GhostsStateMachine& sm, const double chase_schedule[]) {
   }
 }
 
-static bool can_step_into_door(MOVEMENT_DIR dir, const Entity& ghost, bool from_inside_pen) {
+static bool can_step_into_door(MOVEMENT_DIR dir, bool is_dead, bool from_inside_pen) {
   // Entering the pen is only from above (moving DOWN) and only when dead.
-  if (dir == MOVEMENT_DIR::DOWN) return ghost.is_dead;
+  if (dir == MOVEMENT_DIR::DOWN) return is_dead;
 
   // Allow leaving pen upward when alive
-  if (dir == MOVEMENT_DIR::UP)   return from_inside_pen && !ghost.is_dead;
+  if (dir == MOVEMENT_DIR::UP)   return from_inside_pen && !is_dead;
   return false;
 }
 
 static bool is_walkable(TILE_TYPE dest, MOVEMENT_DIR dir,
-                        const Entity& ghost, bool from_inside_pen) {
+                        bool is_dead, bool from_inside_pen) {
   if (dest == TILE_TYPE::WALL)  return false;
   if (dest != TILE_TYPE::DOOR)  return true;
-  return can_step_into_door(dir, ghost, from_inside_pen);
+  return can_step_into_door(dir, is_dead, from_inside_pen);
 }
 
-static Vector2 get_scatter_target(GHOST_TYPE ghost, const GhostContext& ctx){
+static TilePos get_scatter_target(GHOST_TYPE ghost, const GhostContext& ctx){
+  const std::int16_t right_col = static_cast<std::int16_t>(ctx.map.cols - 2);
+  const std::int16_t bottom_row = static_cast<std::int16_t>(ctx.map.rows - 1);
   switch(ghost){
-    case GHOST_TYPE::BLINKY: return { (float)ctx.map.cols - 2, 0 };
+    case GHOST_TYPE::BLINKY: return { right_col, 0 };
     case GHOST_TYPE::PINKY:  return { 2, 0 };
-    case GHOST_TYPE::INKY:   return { (float)ctx.map.cols - 2, (float)ctx.map.rows - 1 };
-    case GHOST_TYPE::CLYDE:  return { 2, (float)ctx.map.rows - 1 };
+    case GHOST_TYPE::INKY:   return { right_col, bottom_row };
+    case GHOST_TYPE::CLYDE:  return { 2, bottom_row };
     default:                 return {};
   }
 }
 
-static Vector2 get_chase_target(GHOST_TYPE type, const Entity& ghost,
+static TilePos get_chase_target(GHOST_TYPE type, EntityId ghost,
                                 const GhostContext& ctx){
+  const TilePos player_pos = ctx.entities.tile_pos[PLAYER_ID];
   switch(type){
     case GHOST_TYPE::BLINKY:
-      return ctx.player.tile_pos;
+      return player_pos;
 
     case GHOST_TYPE::PINKY: {
-      Vector2 t = get_tile_pos_ahead_of_entity(ctx.player, 4); return t;
+      TilePos t = get_tile_pos_ahead_of_entity(ctx.entities, PLAYER_ID, 4); return t;
     }
 
     case GHOST_TYPE::INKY: {
-      Vector2 two = get_tile_pos_ahead_of_entity(ctx.player, 2);
-      Vector2 v{ two.x - ctx.blinky.tile_pos.x, two.y - ctx.blinky.tile_pos.y };
-      return { two.x + v.x, two.y + v.y };
+      // Without a Blinky in the maze Inky mirrors around himself
+      const EntityId blinky = (ctx.blinky != NO_ENTITY) ? ctx.blinky : ghost;
+      TilePos two = get_tile_pos_ahead_of_entity(ctx.entities, PLAYER_ID, 2);
+      TilePos v = two - ctx.entities.tile_pos[blinky];
+      return two + v;
     }
 
     case GHOST_TYPE::CLYDE: {
-      float dx = ctx.player.tile_pos.x - ghost.tile_pos.x;
-      float dy = ctx.player.tile_pos.y - ghost.tile_pos.y;
-      float d2 = Vector2DistanceSqr(ctx.player.tile_pos, ghost.tile_pos);
-      return (d2 >= 64.0f) ? ctx.player.tile_pos : get_scatter_target(GHOST_TYPE::CLYDE, ctx);
+      std::int32_t d2 = get_tile_distance_sqr(player_pos, ctx.entities.tile_pos[ghost]);
+      return (d2 >= 64) ? player_pos : get_scatter_target(GHOST_TYPE::CLYDE, ctx);
     }
     default: return {};
   }
 }
 
-static void update_ghost_tile_pos(Entity* entity, MOVEMENT_DIR new_dir, float dt) {
-  // entity->move_timer += (1.0f / 60.0f);
-  entity->move_timer += dt;
-  while (entity->move_timer >= entity->tile_step_time) {
-    entity->move_timer -= entity->tile_step_time;
+static void update_ghost_tile_pos(EntityStore* entities, EntityId id,
+                                  MOVEMENT_DIR new_dir, float dt) {
+  float& move_timer = entities->move_timer[id];
+  move_timer += dt;
+  while (move_timer >= entities->tile_step_time[id]) {
+    move_timer -= entities->tile_step_time[id];
 
     // Update direction only once per tile
-    entity->dir = new_dir;
+    entities->dir[id] = new_dir;
 
     // Record previous tile BEFORE we step
-    entity->prev_tile_pos = entity->tile_pos;
-    Vector2 delta = get_step_delta(entity->dir);
-    entity->tile_pos.x += delta.x;
-    entity->tile_pos.y += delta.y;
+    entities->prev_tile_pos[id] = entities->tile_pos[id];
+    entities->tile_pos[id] = entities->tile_pos[id] + get_step_delta(new_dir);
   }
 }
 
-static void move_to_tile(const TileMap& tile_map,
-                         Entity* blinky, const Vector2& target_tile_pos,
+// Shortest path version of the candidate scoring in move_to_tile(). Returns
+// false if the target can't be reached (off the map, inside a wall or in a
+// disconnected part of the maze), the caller then falls back to the
+// straight line distance.
+static bool pick_shortest_path_dir(DistanceFieldCache* distance_fields,
+                                   const TileMap& tile_map,
+                                   const EntityStore& entities, EntityId ghost,
+                                   TilePos target_tile_pos,
+                                   MOVEMENT_DIR forbidden_dir, MOVEMENT_DIR* out_dir) {
+  if (!tile_map.in_bounds(target_tile_pos)) return false;
+
+  const std::uint16_t* field = get_distance_field(distance_fields, tile_map,
+    static_cast<std::uint16_t>(target_tile_pos.col),
+    static_cast<std::uint16_t>(target_tile_pos.row));
+  if (!field) return false;
+
+  // Same priority as the straight line scoring, the first of equally
+  // distant tiles wins
+  std::uint16_t best_dist = DistanceFieldCache::UNREACHABLE;
+
+  for (MOVEMENT_DIR dir : GHOST_SCORING_DIRS) {
+    if (dir == forbidden_dir) continue;
+    TilePos pos = entities.tile_pos[ghost] + get_step_delta(dir);
+    if (!tile_map.in_bounds(pos)) continue;
+    if (!is_walkable(tile_map.get(pos), dir, entities.is_dead[ghost],
+                     entities.in_monster_pen[ghost])) continue;
+
+    const std::uint16_t dist = get_field_distance(*distance_fields, field, tile_map,
+                                                  static_cast<std::uint16_t>(pos.col),
+                                                  static_cast<std::uint16_t>(pos.row));
+    if (dist < best_dist) {
+      best_dist = dist;
+      *out_dir = dir;
+    }
+  }
+
+  return best_dist != DistanceFieldCache::UNREACHABLE;
+}
+
+// Only a single walkable option left, e.g. inside a corridor. Doors are
+// walkable depending on the ghost's state, so tiles next to one always
+// go through the full scoring.
+static MOVEMENT_DIR get_forced_dir(const TileExitMasks* exit_masks, const TileMap& tile_map,
+                                   TilePos ghost_pos, MOVEMENT_DIR forbidden_dir) {
+  if (!are_exit_masks_valid(exit_masks, tile_map)) return MOVEMENT_DIR::STOPPED;
+  if (!tile_map.in_bounds(ghost_pos)) return MOVEMENT_DIR::STOPPED;
+
+  const std::size_t idx = tile_map.index(ghost_pos);
+  if (exit_masks->door_mask[idx]) return MOVEMENT_DIR::STOPPED;
+  return get_single_dir(exit_masks->exit_mask[idx] & ~get_dir_bit(forbidden_dir));
+}
+
+static void move_to_tile(const TileMap& tile_map, DistanceFieldCache* distance_fields,
+                         const TileExitMasks* exit_masks, EntityStore* entities, EntityId ghost,
+                         TilePos target_tile_pos,
                          MOVEMENT_DIR forbidden_dir, float dt) {
-  if (forbidden_dir == MOVEMENT_DIR::STOPPED && blinky->dir != MOVEMENT_DIR::STOPPED) {
-    forbidden_dir = get_opposite_dir(blinky->dir);
+  const MOVEMENT_DIR dir = entities->dir[ghost];
+  if (forbidden_dir == MOVEMENT_DIR::STOPPED && dir != MOVEMENT_DIR::STOPPED) {
+    forbidden_dir = get_opposite_dir(dir);
   }
   
-  float& blinky_x = blinky->tile_pos.x;
-  float& blinky_y = blinky->tile_pos.y;
-  
-  TILE_TYPE current_tile = tile_map.get(blinky_x, blinky_y);
+  TILE_TYPE current_tile = tile_map.get(entities->tile_pos[ghost]);
   if (current_tile == TILE_TYPE::TELEPORT) {
-    handle_entity_on_teleport_tile(blinky, tile_map.cols);
+    handle_entity_on_teleport_tile(entities, ghost, tile_map.cols);
+  }
+
+  // The new direction is only applied when stepping onto the next tile,
+  // no need to pick one on ticks that don't step
+  if (entities->move_timer[ghost] + dt < entities->tile_step_time[ghost]) {
+    entities->move_timer[ghost] += dt;
+    return;
+  }
+
+  const TilePos ghost_pos = entities->tile_pos[ghost];
+  const MOVEMENT_DIR forced_dir = get_forced_dir(exit_masks, tile_map, ghost_pos, forbidden_dir);
+  if (forced_dir != MOVEMENT_DIR::STOPPED) {
+    update_ghost_tile_pos(entities, ghost, forced_dir, dt);
+    return;
+  }
+
+  MOVEMENT_DIR shortest_path_dir = MOVEMENT_DIR::STOPPED;
+  if (distance_fields &&
+      pick_shortest_path_dir(distance_fields, tile_map, *entities, ghost, target_tile_pos,
+                             forbidden_dir, &shortest_path_dir)) {
+    update_ghost_tile_pos(entities, ghost, shortest_path_dir, dt);
+    return;
+  }
+
+  // Gather candidates, the scoring itself happens in one pass over all four
+  GhostScoringInput scoring{ ghost_pos, target_tile_pos, 0, 0 };
+  const bool is_dead = entities->is_dead[ghost];
+  const bool from_inside_pen = entities->in_monster_pen[ghost];
+
+  for (std::uint8_t lane = 0; lane < 4; ++lane) {
+    const MOVEMENT_DIR dir = GHOST_SCORING_DIRS[lane];
+    if (dir == forbidden_dir) continue;
+
+    scoring.candidate_mask |= std::uint8_t(1u << lane);
+    if (is_walkable(tile_map.get(ghost_pos + get_step_delta(dir)), dir, is_dead, from_inside_pen)) {
+      scoring.walkable_mask |= std::uint8_t(1u << lane);
+    }
   }
 
-  // Gather candidates
-  PathTile candidates[4];
-  size_t candidates_idx = 0;
-
-  auto consider = [&](MOVEMENT_DIR dir) {
-    if (dir == forbidden_dir) return;
-    Vector2 delta = get_step_delta(dir);
-    Vector2 pos   = { blinky_x + delta.x, blinky_y + delta.y };
-    TILE_TYPE tile  = tile_map.get(pos.x, pos.y);
-
-    bool from_inside_pen = blinky->in_monster_pen;
-
-    float dist = Vector2DistanceSqr(pos, target_tile_pos);
-    bool walk   = is_walkable(tile, dir, *blinky, from_inside_pen);
-    candidates[candidates_idx++]   = PathTile{ dir, dist, walk };
-  };
-
-  consider(MOVEMENT_DIR::UP);
-  consider(MOVEMENT_DIR::DOWN);
-  consider(MOVEMENT_DIR::LEFT);
-  consider(MOVEMENT_DIR::RIGHT);
-
-  std::sort(candidates, candidates + candidates_idx,
-            [](const PathTile& a, const PathTile& b) {
-    if (a.walkable != b.walkable) return a.walkable;   // check if walkable at all before else
-    if (a.dist != b.dist)         return a.dist < b.dist;
-    return prioritize_dir(a.dir) < prioritize_dir(b.dir);
-  });
-
-  MOVEMENT_DIR new_dir = candidates_idx ? candidates[0].dir : MOVEMENT_DIR::RIGHT;
-  update_ghost_tile_pos(blinky, new_dir, dt);
+  MOVEMENT_DIR new_dir = MOVEMENT_DIR::RIGHT;
+  score_ghost_candidates(&scoring, 1, &new_dir);
+  update_ghost_tile_pos(entities, ghost, new_dir, dt);
 }
 
 void update_ghosts_global_sm(GhostsStateMachine* phase, bool is_player_energized,
@@ -204,58 +256,69 @@ void update_ghosts_global_sm(GhostsStateMachine* phase, bool is_player_energized
   }
 }
 
-void update_ghost(Entity* ghost, GHOST_TYPE type, const GhostContext& ctx, float dt) {
-  if (ghost->dir == MOVEMENT_DIR::STOPPED) {
-    ghost->dir = MOVEMENT_DIR::RIGHT;
+void update_ghost(EntityStore* entities, EntityId id, const GhostContext& ctx, float dt) {
+  MOVEMENT_DIR& dir = entities->dir[id];
+  const TilePos tile_pos = entities->tile_pos[id];
+  bool& is_dead = entities->is_dead[id];
+  bool& in_monster_pen = entities->in_monster_pen[id];
+
+  if (dir == MOVEMENT_DIR::STOPPED) {
+    dir = MOVEMENT_DIR::RIGHT;
   }
 
   MOVEMENT_DIR forbidden = MOVEMENT_DIR::STOPPED;
 
   // Reverse once per phase change
-  if (ghost->last_seen_change_seq != ctx.phase.change_seq) {
-    forbidden = ghost->dir;
-    ghost->dir = get_opposite_dir(ghost->dir);
-    ghost->last_seen_change_seq = ctx.phase.change_seq;
+  if (entities->last_seen_change_seq[id] != ctx.phase.change_seq) {
+    forbidden = dir;
+    dir = get_opposite_dir(dir);
+    entities->last_seen_change_seq[id] = ctx.phase.change_seq;
   }
 
-  Vector2 target{};
+  TilePos target{};
   // Exit pen first
-  if (ghost->in_monster_pen) {
-    if (Vector2Equals(ghost->tile_pos, ctx.pen_door))
-      ghost->in_monster_pen = false;
+  if (in_monster_pen) {
+    if (tile_pos == ctx.pen_door)
+      in_monster_pen = false;
     else 
       target = ctx.pen_door;
   }
 
   // Being dead overrides all other states
-  if (ghost->is_dead) {
+  if (is_dead) {
     target = ctx.pen_home;
-    if (Vector2Equals(ghost->tile_pos, ctx.pen_home)) {
-      ghost->is_dead = false;
-      ghost->in_monster_pen = true;
+    if (tile_pos == ctx.pen_home) {
+      is_dead = false;
+      in_monster_pen = true;
     }
   }
 
   // If no target tile is forced we can finally set the
   // target tile based on global state machine state 
-  if (target.x == 0 && target.y == 0 &&
-      !(ghost->is_dead || ghost->in_monster_pen)) {
+  if (target == TilePos{0, 0} &&
+      !(is_dead || in_monster_pen)) {
+    const GHOST_TYPE type = entities->ghost_type[id];
     switch (ctx.phase.state) {
     case GHOST_STATE::SCATTER: {
       target = get_scatter_target(type, ctx);
     } break;
     case GHOST_STATE::CHASE: {
-      target = get_chase_target(type, *ghost, ctx);
+      target = get_chase_target(type, id, ctx);
     } break;
     case GHOST_STATE::FRIGHTENED: {
-      target = {
-        (float)GetRandomValue(0, ctx.map.cols - 1),
-        (float)GetRandomValue(0, ctx.map.rows - 1)
-      };
+      target.col = static_cast<std::int16_t>(get_sim_random_value(ctx.random, 0, ctx.map.cols - 1));
+      target.row = static_cast<std::int16_t>(get_sim_random_value(ctx.random, 0, ctx.map.rows - 1));
     } break;
     default: break;
     }
   }
 
-  move_to_tile(ctx.map, ghost, target, forbidden, dt);
+  move_to_tile(ctx.map, ctx.distance_fields, ctx.exit_masks, entities, id, target, forbidden, dt);
+}
+
+void update_ghosts(EntityStore* entities, const GhostContext& ctx, float dt) {
+  for (EntityId id = PLAYER_ID + 1; id < entities->count; ++id) {
+    ProfileScope scope(ctx.profiler, "update_ghost", id);
+    update_ghost(entities, id, ctx, dt);
+  }
 }
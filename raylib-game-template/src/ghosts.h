@@ -2,11 +2,14 @@
 #include <cstdint>
 #include <cmath>
 #include <limits>
-#include "raylib.h"
 #include "tile_map.h"
 #include "movement_dir.h"
 #include "entity.h"
 #include "timer.h"
+#include "nav.h"
+#include "tile_exit_masks.h"
+#include "sim_random.h"
+#include "profiler.h"
 
 enum class GHOST_STATE : std::uint8_t {
     NONE = 0,
@@ -16,20 +19,6 @@ enum class GHOST_STATE : std::uint8_t {
     EATEN,
 };
 
-enum class GHOST_TYPE : std::uint8_t {
-    NONE = 0,
-    BLINKY,
-    PINKY,
-    INKY,
-    CLYDE,
-};
-
-struct PathTile {
-  MOVEMENT_DIR dir;
-  float dist;
-  bool walkable;
-};
-
 struct GhostsStateMachine {
   GHOST_STATE state{GHOST_STATE::NONE};
   Timer main_timer{};                         // for SCATTER/CHASE
@@ -44,14 +33,24 @@ struct GhostsStateMachine {
 struct GhostContext {
   const TileMap& map;
   const GhostsStateMachine& phase;
-  const Entity& player;
-  const Entity& blinky;     // needed by Inky’s chase rule
-  Vector2 pen_door;   // usually {13,14}
-  Vector2 pen_home;   // usually {13,17}
+  const EntityStore& entities;
+  EntityId blinky;    // needed by Inky’s chase rule, see find_ghost()
+  TilePos pen_door;   // usually {13,14}
+  TilePos pen_home;   // usually {13,17}
+  SimRandom* random;  // the game's own generator, for FRIGHTENED targets
+  // Optional, when set ghosts follow the shortest path to their target
+  // instead of picking the tile closest to it in a straight line
+  DistanceFieldCache* distance_fields = nullptr;
+  // Optional, lets ghosts skip decision making inside corridors
+  const TileExitMasks* exit_masks = nullptr;
+  // Optional, times each ghost's and step_game()'s phases
+  FrameProfiler* profiler = nullptr;
 };
 
 void update_ghosts_global_sm(GhostsStateMachine* phase, bool is_player_energized,
                              const double scatter_schedule[],
                              const double chase_schedule[],
                              float dt);
-void update_ghost(Entity* g, GHOST_TYPE type, const GhostContext& ctx, float dt);
+void update_ghost(EntityStore* entities, EntityId id, const GhostContext& ctx, float dt);
+// Updates every ghost in the store, in id order
+void update_ghosts(EntityStore* entities, const GhostContext& ctx, float dt);
@@ -0,0 +1,521 @@
+// Headless simulation driver: plays many games back to back with a random
+// player, without opening a window or touching the GPU. Meant for batch
+// evaluation on machines without a display.
+//
+// Usage: pacman_headless [num_games] [seed] [max_steps_per_game] [euclid|bfs] [num_envs] [num_threads]
+//        pacman_headless replay <replay_file>...
+//        pacman_headless level <level_file>...
+//        pacman_headless compile <level_txt> <level_pml>
+//        pacman_headless generate <cols> <rows> <seed> <out.txt|out.pml> [corridor_density] [num_ghosts]
+//        pacman_headless scoring [num_random_inputs] [seed]
+//
+// "bfs" makes the ghosts follow shortest paths (see nav.h) instead of the
+// arcade's straight line targeting. A non zero num_envs runs that many games
+// in lockstep through the batched API (see vec_env.h) for max_steps_per_game
+// steps instead. A non zero num_threads plays the games on that many threads
+// (see batch_runner.h).
+//
+// "replay" re-simulates recorded games (see replay.h) and checks they end
+// the same way, exiting with 1 if any of them doesn't. "level" loads text
+// levels (see level_file.h), reports their size and the parse rate and exits
+// with 1 if any of them is invalid, .pml files are opened as compiled levels.
+// "compile" turns a text level into a compiled one (see level_binary.h).
+// "generate" writes a procedural maze (see maze_gen.h) in either format.
+// "scoring" checks the SIMD ghost scoring kernel against the scalar one
+// (see ghost_scoring.h) and exits with 1 if they ever pick differently.
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "level.h"
+#include "classic_level.h"
+#include "movement_dir.h"
+#include "ghosts.h"
+#include "sim.h"
+#include "sim_random.h"
+#include "nav.h"
+#include "tile_exit_masks.h"
+#include "vec_env.h"
+#include "batch_runner.h"
+#include "game_sim.h"
+#include "replay.h"
+#include "level_file.h"
+#include "level_binary.h"
+#include "maze_gen.h"
+#include "ghost_scoring.h"
+
+static constexpr MOVEMENT_DIR dirs[4] = { MOVEMENT_DIR::UP, MOVEMENT_DIR::DOWN,
+                                          MOVEMENT_DIR::LEFT, MOVEMENT_DIR::RIGHT };
+
+static int run_vec_env(std::uint32_t num_envs, std::uint64_t seed, std::uint32_t num_steps,
+                       bool shortest_path);
+static int run_batched(std::uint32_t num_games, std::uint64_t seed, std::uint32_t max_steps,
+                       bool shortest_path, std::uint32_t num_threads);
+static int run_replays(int num_paths, char** paths);
+static int run_level_loads(int num_paths, char** paths);
+static int run_level_compile(const char* text_path, const char* binary_path);
+static int run_maze_generate(int argc, char** argv);
+static int run_scoring_check(std::uint32_t num_random, std::uint64_t seed);
+
+int main(int argc, char** argv) {
+  if (argc > 1 && std::strcmp(argv[1], "replay") == 0) return run_replays(argc - 2, argv + 2);
+  if (argc > 1 && std::strcmp(argv[1], "level") == 0) return run_level_loads(argc - 2, argv + 2);
+  if (argc > 3 && std::strcmp(argv[1], "compile") == 0) return run_level_compile(argv[2], argv[3]);
+  if (argc > 5 && std::strcmp(argv[1], "generate") == 0) return run_maze_generate(argc - 2, argv + 2);
+  if (argc > 1 && std::strcmp(argv[1], "scoring") == 0) {
+    const std::uint32_t num_random = (argc > 2) ? static_cast<std::uint32_t>(std::strtoul(argv[2], nullptr, 10)) : 1000000;
+    const std::uint64_t seed = (argc > 3) ? std::strtoull(argv[3], nullptr, 10) : 1;
+    return run_scoring_check(num_random, seed);
+  }
+
+  const std::uint32_t num_games = (argc > 1) ? static_cast<std::uint32_t>(std::strtoul(argv[1], nullptr, 10)) : 1000;
+  const std::uint64_t seed      = (argc > 2) ? std::strtoull(argv[2], nullptr, 10) : 1;
+  const std::uint32_t max_steps = (argc > 3) ? static_cast<std::uint32_t>(std::strtoul(argv[3], nullptr, 10)) : 120 * 60 * 5;
+  const bool shortest_path      = (argc > 4) && std::strcmp(argv[4], "bfs") == 0;
+  const std::uint32_t num_envs  = (argc > 5) ? static_cast<std::uint32_t>(std::strtoul(argv[5], nullptr, 10)) : 0;
+  const std::uint32_t num_threads = (argc > 6) ? static_cast<std::uint32_t>(std::strtoul(argv[6], nullptr, 10)) : 0;
+
+  if (num_envs > 0) return run_vec_env(num_envs, seed, max_steps, shortest_path);
+  if (num_threads > 0) return run_batched(num_games, seed, max_steps, shortest_path, num_threads);
+
+  // The random player and the ghosts draw from the same stream here
+  SimRandom random = {};
+  seed_sim_random(&random, seed);
+
+  std::uint32_t won = 0;
+  std::uint32_t lost = 0;
+  std::uint64_t total_steps = 0;
+  std::uint64_t total_dots = 0;
+
+  const auto start = std::chrono::steady_clock::now();
+
+  for (std::uint32_t game = 0; game < num_games; ++game) {
+    auto [tile_map_ptr, entities_ptr] = parse_level(get_classic_level(), CLASSIC_TILE_SIZE);
+    TileMap& tile_map = *tile_map_ptr;
+    EntityStore& entities = *entities_ptr;
+
+    TileExitMasks exit_masks = {};
+    sync_tile_exit_masks(&exit_masks, tile_map);
+
+    DistanceFieldCache distance_fields = {};
+    GhostsStateMachine ghosts_sm = {};
+    GhostContext ghost_ctx{
+      tile_map,
+      ghosts_sm,
+      entities,
+      find_ghost(entities, GHOST_TYPE::BLINKY),
+      CLASSIC_PEN_DOOR,
+      CLASSIC_PEN_HOME,
+      &random,
+      shortest_path ? &distance_fields : nullptr,
+      &exit_masks
+    };
+
+    GAME_STATUS status = GAME_STATUS::PLAYING;
+    std::uint32_t step = 0;
+    for (; step < max_steps; ++step) {
+      status = get_game_status(tile_map, entities);
+      if (status != GAME_STATUS::PLAYING) break;
+
+      // Random player: pick a new direction whenever we're stuck,
+      // otherwise turn every now and then
+      if (entities.dir[PLAYER_ID] == MOVEMENT_DIR::STOPPED ||
+          get_sim_random_value(&random, 0, 31) == 0) {
+        entities.next_dir[PLAYER_ID] = dirs[get_sim_random_value(&random, 0, 3)];
+      }
+
+      step_game(&tile_map, &entities, &ghosts_sm, ghost_ctx,
+                CLASSIC_SCATTER_SCHEDULE, CLASSIC_CHASE_SCHEDULE, SIM_TICK_DT);
+    }
+
+    if (status == GAME_STATUS::WON) ++won;
+    if (status == GAME_STATUS::LOST) ++lost;
+    total_steps += step;
+    total_dots += entities.collected_dots;
+  }
+
+  const auto end = std::chrono::steady_clock::now();
+  const double seconds = std::chrono::duration<double>(end - start).count();
+
+  std::printf("games:      %u (won %u, lost %u, timed out %u)\n",
+              num_games, won, lost, num_games - won - lost);
+  std::printf("avg score:  %.2f dots\n",
+              num_games ? static_cast<double>(total_dots) / num_games : 0.0);
+  std::printf("time:       %.3f s\n", seconds);
+  std::printf("games/sec:  %.1f\n", seconds > 0.0 ? num_games / seconds : 0.0);
+  std::printf("steps/sec:  %.1f\n", seconds > 0.0 ? total_steps / seconds : 0.0);
+  return 0;
+}
+
+static int run_vec_env(std::uint32_t num_envs, std::uint64_t seed, std::uint32_t num_steps,
+                       bool shortest_path) {
+  auto [tile_map_ptr, entities_ptr] = parse_level(get_classic_level(), CLASSIC_TILE_SIZE);
+
+  VecEnvConfig config = {};
+  config.sim.shortest_path_ghosts = shortest_path;
+  config.seed = seed;
+
+  // The games' ghosts get their own streams, this one is for the player
+  SimRandom random = {};
+  seed_sim_random(&random, seed);
+  auto env = std::make_unique<VecEnv>();
+  if (!init_vec_env(env.get(), *tile_map_ptr, *entities_ptr, config)) {
+    std::fprintf(stderr, "level too big for the batched simulation\n");
+    return 1;
+  }
+  reset_vec_env(env.get(), num_envs);
+
+  std::vector<MOVEMENT_DIR> actions(num_envs, MOVEMENT_DIR::STOPPED);
+  std::uint64_t episodes = 0;
+  double total_reward = 0.0;
+
+  const auto start = std::chrono::steady_clock::now();
+
+  for (std::uint32_t step = 0; step < num_steps; ++step) {
+    // Same random player as the single game loop
+    for (std::uint32_t env_idx = 0; env_idx < num_envs; ++env_idx) {
+      actions[env_idx] = MOVEMENT_DIR::STOPPED;
+      if (env->observations[env_idx].player_dir == MOVEMENT_DIR::STOPPED ||
+          get_sim_random_value(&random, 0, 31) == 0) {
+        actions[env_idx] = dirs[get_sim_random_value(&random, 0, 3)];
+      }
+    }
+
+    step_vec_env(env.get(), actions.data());
+
+    for (std::uint32_t env_idx = 0; env_idx < num_envs; ++env_idx) {
+      total_reward += env->rewards[env_idx];
+      episodes += env->dones[env_idx];
+    }
+  }
+
+  const auto end = std::chrono::steady_clock::now();
+  const double seconds = std::chrono::duration<double>(end - start).count();
+  const double env_steps = static_cast<double>(num_envs) * num_steps;
+
+  std::printf("envs:       %u x %u steps (%llu episodes done)\n", num_envs, num_steps,
+              static_cast<unsigned long long>(episodes));
+  std::printf("avg reward: %.2f per episode\n", episodes ? total_reward / episodes : 0.0);
+  std::printf("time:       %.3f s\n", seconds);
+  std::printf("steps/sec:  %.1f\n", seconds > 0.0 ? env_steps / seconds : 0.0);
+  return 0;
+}
+
+// Same random player as the single game loop
+static MOVEMENT_DIR random_policy(const TileMap&, const EntityStore& entities,
+                                  SimRandom* random, void*) {
+  if (entities.dir[PLAYER_ID] == MOVEMENT_DIR::STOPPED || get_sim_random_value(random, 0, 31) == 0) {
+    return dirs[get_sim_random_value(random, 0, 3)];
+  }
+  return MOVEMENT_DIR::STOPPED;
+}
+
+static int run_batched(std::uint32_t num_games, std::uint64_t seed, std::uint32_t max_steps,
+                       bool shortest_path, std::uint32_t num_threads) {
+  auto [tile_map_ptr, entities_ptr] = parse_level(get_classic_level(), CLASSIC_TILE_SIZE);
+
+  BatchRunConfig config = {};
+  config.num_threads = num_threads;
+  config.max_steps_per_game = max_steps;
+  config.seed = seed;
+  config.sim.shortest_path_ghosts = shortest_path;
+  std::vector<GameResult> results(num_games);
+
+  const auto start = std::chrono::steady_clock::now();
+  run_games_batched(*tile_map_ptr, *entities_ptr, num_games, random_policy, nullptr,
+                    config, results.data());
+  const auto end = std::chrono::steady_clock::now();
+  const double seconds = std::chrono::duration<double>(end - start).count();
+
+  std::uint32_t won = 0;
+  std::uint32_t lost = 0;
+  std::uint64_t total_steps = 0;
+  std::uint64_t total_dots = 0;
+  for (const GameResult& result : results) {
+    if (result.status == GAME_STATUS::WON) ++won;
+    if (result.status == GAME_STATUS::LOST) ++lost;
+    total_steps += result.steps;
+    total_dots += result.collected_dots;
+  }
+
+  std::printf("games:      %u on %u threads (won %u, lost %u, timed out %u)\n",
+              num_games, num_threads, won, lost, num_games - won - lost);
+  std::printf("avg score:  %.2f dots\n",
+              num_games ? static_cast<double>(total_dots) / num_games : 0.0);
+  std::printf("time:       %.3f s\n", seconds);
+  std::printf("games/sec:  %.1f\n", seconds > 0.0 ? num_games / seconds : 0.0);
+  std::printf("steps/sec:  %.1f\n", seconds > 0.0 ? total_steps / seconds : 0.0);
+  return 0;
+}
+
+// Sets *sim up for the level a replay was recorded on, the same way the
+// game does: the classic maze, or a level file with its own pen
+// The sim plays on *level's layers, which has to be kept along with it
+static bool init_replay_sim(GameSim* sim, LevelLoad* level, const std::string& level_path) {
+  if (level_path.empty()) {
+    *level = LevelLoad{};
+    std::tie(level->tile_map, level->entities) = parse_level(get_classic_level(), CLASSIC_TILE_SIZE);
+    return init_game_sim_shared(sim, *level->tile_map, *level->entities, GameSimConfig{});
+  }
+
+  *level = load_level(level_path.c_str(), CLASSIC_TILE_SIZE);
+  if (!level->ok()) {
+    std::printf("%s: %s\n", level_path.c_str(), get_level_error_name(level->error));
+    return false;
+  }
+  GameSimConfig config = {};
+  if (level->has_pen) {
+    config.pen_door = level->pen_door;
+    config.pen_home = level->pen_home;
+  }
+  if (!init_game_sim_shared(sim, *level->tile_map, *level->entities, config)) {
+    std::printf("%s: too big for the game simulation\n", level_path.c_str());
+    return false;
+  }
+  return true;
+}
+
+static int run_replays(int num_paths, char** paths) {
+  // Replays of the same level in a row share its GameSim
+  auto sim = std::make_unique<GameSim>();
+  LevelLoad sim_level = {};
+  std::string sim_level_path;
+  bool sim_ready = false;
+
+  GameState state = {};
+  GameLayers layers = {};
+  Replay replay = {};
+  std::uint32_t failed = 0;
+  std::uint64_t total_ticks = 0;
+  double seconds = 0.0;
+
+  for (int i = 0; i < num_paths; ++i) {
+    if (!load_replay(&replay, paths[i])) {
+      std::printf("%s: can't read replay\n", paths[i]);
+      ++failed;
+      continue;
+    }
+
+    if (!sim_ready || replay.level_path != sim_level_path) {
+      sim = std::make_unique<GameSim>();
+      sim_level_path = replay.level_path;
+      sim_ready = init_replay_sim(sim.get(), &sim_level, sim_level_path);
+    }
+    if (!sim_ready) {
+      std::printf("%s: can't play level %s\n", paths[i], replay.level_path.c_str());
+      ++failed;
+      continue;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    const ReplayCheck check = play_replay(sim.get(), &state, replay, &layers);
+    const auto end = std::chrono::steady_clock::now();
+    seconds += std::chrono::duration<double>(end - start).count();
+    total_ticks += replay.num_ticks;
+
+    if (!check.ok()) {
+      ++failed;
+      if (!check.level_matches) std::printf("%s: recorded on another level\n", paths[i]);
+      std::printf("%s: MISMATCH dots %u (recorded %u), hash %016llx (recorded %016llx)\n",
+                  paths[i], check.final_dots, replay.final_dots,
+                  static_cast<unsigned long long>(check.final_hash),
+                  static_cast<unsigned long long>(replay.final_hash));
+    }
+  }
+
+  std::printf("replays:    %d (%u failed)\n", num_paths, failed);
+  std::printf("time:       %.3f s\n", seconds);
+  std::printf("ticks/sec:  %.1f\n", seconds > 0.0 ? total_ticks / seconds : 0.0);
+  return failed ? 1 : 0;
+}
+
+static void print_level_error(const char* path, LEVEL_ERROR error, std::uint32_t line) {
+  if (line) {
+    std::printf("%s: line %u: %s\n", path, line, get_level_error_name(error));
+  } else {
+    std::printf("%s: %s\n", path, get_level_error_name(error));
+  }
+}
+
+static bool has_extension(const char* path, const char* extension) {
+  const std::size_t path_len = std::strlen(path);
+  const std::size_t ext_len = std::strlen(extension);
+  return path_len >= ext_len && std::strcmp(path + path_len - ext_len, extension) == 0;
+}
+
+static int run_level_loads(int num_paths, char** paths) {
+  std::uint32_t failed = 0;
+  std::uint64_t total_bytes = 0;
+  std::uint64_t total_tiles = 0;
+  double seconds = 0.0;
+
+  auto mapped = std::make_unique<MappedLevel>();
+  for (int i = 0; i < num_paths; ++i) {
+    // Compiled levels only cost the mapping and counting the dots, touching
+    // the other tiles is up to whoever uses them
+    if (has_extension(paths[i], ".pml")) {
+      const auto start = std::chrono::steady_clock::now();
+      const LEVEL_ERROR error = open_mapped_level(mapped.get(), paths[i]);
+      const double map_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+      if (error != LEVEL_ERROR::NONE) {
+        ++failed;
+        print_level_error(paths[i], error, 0);
+        continue;
+      }
+
+      const TileMap& tile_map = mapped->tile_map;
+      std::printf("%s: %ux%u, %u dots, %u ghosts, %.3f ms (mapped)\n", paths[i], tile_map.cols,
+                  tile_map.rows, tile_map.all_dots, mapped->entities.num_ghosts(), map_seconds * 1e3);
+      total_bytes += mapped->size;
+      total_tiles += std::uint64_t(tile_map.cols) * tile_map.rows;
+      seconds += map_seconds;
+      close_mapped_level(mapped.get());
+      continue;
+    }
+
+    const LevelLoad level = load_level_file(paths[i], CLASSIC_TILE_SIZE);
+    if (!level.ok()) {
+      ++failed;
+      print_level_error(paths[i], level.error, level.error_line);
+      continue;
+    }
+
+    const TileMap& tile_map = *level.tile_map;
+    std::printf("%s: %ux%u, %u dots, %u ghosts, %.3f ms\n", paths[i], tile_map.cols, tile_map.rows,
+                tile_map.all_dots, level.entities->num_ghosts(), level.seconds * 1e3);
+    total_bytes += level.bytes;
+    total_tiles += std::uint64_t(tile_map.cols) * tile_map.rows;
+    seconds += level.seconds;
+  }
+
+  std::printf("levels:     %d (%u failed)\n", num_paths, failed);
+  std::printf("time:       %.3f s\n", seconds);
+  std::printf("MB/sec:     %.1f\n", seconds > 0.0 ? total_bytes / seconds / 1e6 : 0.0);
+  std::printf("tiles/sec:  %.1f\n", seconds > 0.0 ? total_tiles / seconds : 0.0);
+  return failed ? 1 : 0;
+}
+
+static int run_level_compile(const char* text_path, const char* binary_path) {
+  const LevelLoad level = load_level_file(text_path, CLASSIC_TILE_SIZE);
+  if (!level.ok()) {
+    print_level_error(text_path, level.error, level.error_line);
+    return 1;
+  }
+
+  TilePos pen_door = {};
+  TilePos pen_home = {};
+  const bool has_pen = find_level_pen(*level.tile_map, &pen_door, &pen_home);
+  const LEVEL_ERROR error = save_level_binary(binary_path, *level.tile_map, *level.entities,
+                                              has_pen ? &pen_door : nullptr, has_pen ? &pen_home : nullptr);
+  if (error != LEVEL_ERROR::NONE) {
+    print_level_error(binary_path, error, 0);
+    return 1;
+  }
+  std::printf("%s: %ux%u, parsed in %.3f ms\n", binary_path, level.tile_map->cols, level.tile_map->rows,
+              level.seconds * 1e3);
+  return 0;
+}
+
+static int run_maze_generate(int argc, char** argv) {
+  MazeGenConfig config = {};
+  config.cols = static_cast<std::uint16_t>(std::strtoul(argv[0], nullptr, 10));
+  config.rows = static_cast<std::uint16_t>(std::strtoul(argv[1], nullptr, 10));
+  config.seed = std::strtoull(argv[2], nullptr, 10);
+  const char* path = argv[3];
+  if (argc > 4) config.corridor_density = std::strtof(argv[4], nullptr);
+  if (argc > 5) config.num_ghosts = static_cast<std::uint16_t>(std::strtoul(argv[5], nullptr, 10));
+
+  const auto start = std::chrono::steady_clock::now();
+  const std::vector<std::string> lines = generate_maze_lines(config);
+  const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  if (lines.empty()) {
+    std::fprintf(stderr, "can't generate a %ux%u maze (at least %ux%u with a pen)\n", config.cols, config.rows,
+                 MAZE_GEN_MIN_COLS_WITH_PEN, MAZE_GEN_MIN_ROWS_WITH_PEN);
+    return 1;
+  }
+
+  LEVEL_ERROR error = LEVEL_ERROR::NONE;
+  if (has_extension(path, ".pml")) {
+    auto [tile_map, entities] = parse_level(lines, CLASSIC_TILE_SIZE);
+    TilePos pen_door = {};
+    TilePos pen_home = {};
+    const bool has_pen = find_level_pen(*tile_map, &pen_door, &pen_home);
+    error = save_level_binary(path, *tile_map, *entities, has_pen ? &pen_door : nullptr,
+                              has_pen ? &pen_home : nullptr);
+  } else {
+    std::FILE* file = std::fopen(path, "wb");
+    bool written = file != nullptr;
+    for (const std::string& line : lines) {
+      written = written && std::fwrite(line.data(), 1, line.size(), file) == line.size() &&
+                std::fputc('\n', file) != EOF;
+    }
+    if (file) written = (std::fclose(file) == 0) && written;
+    if (!written) error = LEVEL_ERROR::CANT_WRITE;
+  }
+  if (error != LEVEL_ERROR::NONE) {
+    print_level_error(path, error, 0);
+    return 1;
+  }
+
+  std::printf("%s: %ux%u, seed %llu, generated in %.3f ms\n", path, config.cols, config.rows,
+              static_cast<unsigned long long>(config.seed), seconds * 1e3);
+  return 0;
+}
+
+// Every candidate/walkable mask pair for targets close by, where ties
+// between lanes are common, then random inputs up to the clamped extremes
+static int run_scoring_check(std::uint32_t num_random, std::uint64_t seed) {
+  std::vector<GhostScoringInput> inputs;
+  const TilePos ghost_pos = { 13, 14 };
+  for (std::int16_t dy = -3; dy <= 3; ++dy) {
+    for (std::int16_t dx = -3; dx <= 3; ++dx) {
+      for (std::uint8_t candidates = 0; candidates < 16; ++candidates) {
+        for (std::uint8_t walkable = 0; walkable < 16; ++walkable) {
+          const TilePos target = { static_cast<std::int16_t>(ghost_pos.col + dx),
+                                   static_cast<std::int16_t>(ghost_pos.row + dy) };
+          inputs.push_back(GhostScoringInput{ ghost_pos, target, candidates, walkable });
+        }
+      }
+    }
+  }
+
+  SimRandom random = {};
+  seed_sim_random(&random, seed);
+  for (std::uint32_t i = 0; i < num_random; ++i) {
+    // Mostly nearby targets, some anywhere in TilePos' range
+    const int range = (get_sim_random_value(&random, 0, 3) == 0) ? 32767 : 8;
+    GhostScoringInput input = {};
+    input.tile_pos.col = static_cast<std::int16_t>(get_sim_random_value(&random, -range, range));
+    input.tile_pos.row = static_cast<std::int16_t>(get_sim_random_value(&random, -range, range));
+    input.target.col = static_cast<std::int16_t>(get_sim_random_value(&random, -range, range));
+    input.target.row = static_cast<std::int16_t>(get_sim_random_value(&random, -range, range));
+    input.candidate_mask = static_cast<std::uint8_t>(get_sim_random_value(&random, 0, 15));
+    input.walkable_mask = static_cast<std::uint8_t>(get_sim_random_value(&random, 0, 15));
+    inputs.push_back(input);
+  }
+
+  std::vector<MOVEMENT_DIR> simd_dirs(inputs.size());
+  std::vector<MOVEMENT_DIR> scalar_dirs(inputs.size());
+  score_ghost_candidates(inputs.data(), inputs.size(), simd_dirs.data());
+  score_ghost_candidates_scalar(inputs.data(), inputs.size(), scalar_dirs.data());
+
+  std::uint32_t mismatches = 0;
+  for (std::size_t i = 0; i < inputs.size(); ++i) {
+    if (simd_dirs[i] == scalar_dirs[i]) continue;
+    const GhostScoringInput& input = inputs[i];
+    if (++mismatches <= 10) {
+      std::printf("mismatch: ghost %d,%d target %d,%d candidates %x walkable %x: %d vs scalar %d\n",
+                  input.tile_pos.col, input.tile_pos.row, input.target.col, input.target.row,
+                  input.candidate_mask, input.walkable_mask, static_cast<int>(simd_dirs[i]),
+                  static_cast<int>(scalar_dirs[i]));
+    }
+  }
+  std::printf("inputs:     %zu (%u mismatched)\n", inputs.size(), mismatches);
+  return mismatches ? 1 : 0;
+}
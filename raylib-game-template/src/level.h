@@ -3,30 +3,48 @@
 #include <utility>
 #include <memory>
 #include <string>
+#include <array>
+#include <algorithm>
+#include <vector>
 #include "tile_map.h"
 #include "entity.h"
 
-struct Entities {
-	Entity player;
-	Entity blinky;
-	Entity pinky;
-	Entity inky;
-	Entity clyde;
+struct GhostSpawn {
+    GHOST_TYPE type;
+    TilePos tile_pos;
 };
 
-template<std::uint16_t Rows>
-std::pair<std::unique_ptr<TileMap>, std::unique_ptr<Entities>>
-parse_level(const std::array<std::string, Rows>& level, std::uint16_t tile_size) {
+// Adds the level's ghosts in GHOST_TYPE order, sorting the spawns
+inline void add_ghost_spawns(EntityStore* entities, std::vector<GhostSpawn>* ghost_spawns) {
+    std::stable_sort(ghost_spawns->begin(), ghost_spawns->end(),
+                     [](const GhostSpawn& a, const GhostSpawn& b) { return a.type < b.type; });
+
+    for (const GhostSpawn& spawn : *ghost_spawns) {
+        const EntityId id = add_ghost(entities, spawn.type, spawn.tile_pos, 0.2f); // movement speed of 5 tiles/sec
+        if (id == NO_ENTITY) break;
+
+        // Blinky starts outside of the monster pen
+        if (spawn.type == GHOST_TYPE::BLINKY) entities->in_monster_pen[id] = false;
+    }
+}
+
+// Builds the tile map and the entities' gameplay state. No textures are
+// loaded here, see load_entities_textures() in render.h.
+// Ghosts are added in GHOST_TYPE order (Blinky first), whatever their
+// order in the level, so they always update in the same order.
+// Lines is any container of equally long strings (std::array, std::vector).
+// Level files are read with load_level_file() instead, see level_file.h.
+template<typename Lines>
+std::pair<std::unique_ptr<TileMap>, std::unique_ptr<EntityStore>>
+parse_level(const Lines& level, std::uint16_t tile_size) {
     const std::uint16_t cols = static_cast<std::uint16_t>(level[0].size());
-    const std::uint16_t rows = Rows;
+    const std::uint16_t rows = static_cast<std::uint16_t>(level.size());
 
     // Even though this is just a map of enums let's keep it on the heap,
     // thus freeing ourselves from having to specify its size during compile tima
     auto map = std::make_unique<TileMap>();
     map->tile_size = tile_size;
-    map->rows = rows;
-    map->cols = cols;
-    map->tiles = std::make_unique<TILE_TYPE[]>(cols * rows);
+    map->allocate(cols, rows);
     // Load and create all tile structures we'll need
     TILE_TYPE wall_tile = TILE_TYPE::WALL;
     TILE_TYPE door_tile = TILE_TYPE::DOOR;
@@ -35,7 +53,8 @@ parse_level(const std::array<std::string, Rows>& level, std::uint16_t tile_size)
     TILE_TYPE empty_tile = TILE_TYPE::EMPTY;
     TILE_TYPE teleport_tile = TILE_TYPE::TELEPORT;
 
-    auto entities = std::make_unique<Entities>();
+    auto entities = std::make_unique<EntityStore>();
+    std::vector<GhostSpawn> ghost_spawns;
 
     for (std::uint16_t row = 0; row < rows; ++row) {
         for (std::uint16_t col = 0; col < cols; ++col) {
@@ -62,34 +81,32 @@ parse_level(const std::array<std::string, Rows>& level, std::uint16_t tile_size)
             } break;
             case 'P': {
                 // Player/Pacman
-                Vector2 tile_pos = Vector2{ static_cast<float>(col), static_cast<float>(row) };
-                init_entity(&entities->player, tile_pos, "resources/pacman_texture.png", 0.15f); // movement speed of ~10 tiles/sec
+                TilePos tile_pos = TilePos{ static_cast<std::int16_t>(col), static_cast<std::int16_t>(row) };
+                init_entity(entities.get(), PLAYER_ID, tile_pos, 0.15f); // movement speed of ~10 tiles/sec
                 map->set(col, row, empty_tile);
             } break;
             case 'B': {
                 // Blinky
-                Vector2 tile_pos = Vector2{ static_cast<float>(col), static_cast<float>(row) };
-                init_entity(&entities->blinky, tile_pos,
-                    "resources/blinky_spritesheet.png", 0.2f); // movement speed of 5 tiles/sec
-                entities->blinky.in_monster_pen = false;
+                TilePos tile_pos = TilePos{ static_cast<std::int16_t>(col), static_cast<std::int16_t>(row) };
+                ghost_spawns.push_back({ GHOST_TYPE::BLINKY, tile_pos });
                 map->set(col, row, empty_tile);
             } break;
             case 'I': {
                 // Inky
-                Vector2 tile_pos = Vector2{ static_cast<float>(col), static_cast<float>(row) };
-                init_entity(&entities->inky, tile_pos, "resources/inky_spritesheet.png", 0.2f);
+                TilePos tile_pos = TilePos{ static_cast<std::int16_t>(col), static_cast<std::int16_t>(row) };
+                ghost_spawns.push_back({ GHOST_TYPE::INKY, tile_pos });
                 map->set(col, row, empty_tile);
             } break;
             case 'K': {
                 // Pinky (avoid P clash with Player). In our case Pinky is actually green :/
-                Vector2 tile_pos = Vector2{ static_cast<float>(col), static_cast<float>(row) };
-                init_entity(&entities->pinky, tile_pos, "resources/pinky_spritesheet.png", 0.2f);
+                TilePos tile_pos = TilePos{ static_cast<std::int16_t>(col), static_cast<std::int16_t>(row) };
+                ghost_spawns.push_back({ GHOST_TYPE::PINKY, tile_pos });
                 map->set(col, row, empty_tile);
             } break;
             case 'C': {
                 // Clyde
-                Vector2 tile_pos = Vector2{ static_cast<float>(col), static_cast<float>(row) };
-                init_entity(&entities->clyde, tile_pos, "resources/clyde_spritesheet.png", 0.2f);
+                TilePos tile_pos = TilePos{ static_cast<std::int16_t>(col), static_cast<std::int16_t>(row) };
+                ghost_spawns.push_back({ GHOST_TYPE::CLYDE, tile_pos });
                 map->set(col, row, empty_tile);
             } break;
             default: {
@@ -99,5 +116,7 @@ parse_level(const std::array<std::string, Rows>& level, std::uint16_t tile_size)
         }
     }
 
+    add_ghost_spawns(entities.get(), &ghost_spawns);
+
     return { std::move(map), std::move(entities) };
 }
@@ -0,0 +1,217 @@
+#include "level_binary.h"
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include "level.h"
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static std::uint64_t align_to_8(std::uint64_t offset) {
+  return (offset + 7u) & ~std::uint64_t(7);
+}
+
+LEVEL_ERROR save_level_binary(const char* path, const TileMap& tile_map, const EntityStore& entities,
+                              const TilePos* pen_door, const TilePos* pen_home) {
+  std::vector<LevelBinarySpawn> spawns;
+  spawns.push_back(LevelBinarySpawn{ GHOST_TYPE::NONE, 0, entities.tile_pos[PLAYER_ID] });
+  for (EntityId id = PLAYER_ID + 1; id < entities.count; ++id) {
+    spawns.push_back(LevelBinarySpawn{ entities.ghost_type[id], 0, entities.tile_pos[id] });
+  }
+
+  const std::uint64_t tiles_size = std::uint64_t(NUM_TILE_LAYERS) * tile_map.layer_words() * sizeof(std::uint64_t);
+  LevelBinaryHeader header = {};
+  std::memcpy(header.magic, LEVEL_BINARY_MAGIC, sizeof(header.magic));
+  header.version = LEVEL_BINARY_VERSION;
+  header.cols = tile_map.cols;
+  header.rows = tile_map.rows;
+  header.words_per_row = tile_map.words_per_row;
+  header.tile_size = tile_map.tile_size;
+  header.all_dots = tile_map.all_dots;
+  if (pen_door && pen_home) {
+    header.flags |= LEVEL_BINARY_HAS_PEN;
+    header.pen_door = *pen_door;
+    header.pen_home = *pen_home;
+  }
+  header.num_spawns = static_cast<std::uint32_t>(spawns.size());
+  header.tiles_offset = sizeof(LevelBinaryHeader);
+  header.spawns_offset = header.tiles_offset + tiles_size;
+  header.file_size = align_to_8(header.spawns_offset + spawns.size() * sizeof(LevelBinarySpawn));
+
+  std::FILE* file = std::fopen(path, "wb");
+  if (!file) return LEVEL_ERROR::CANT_WRITE;
+
+  // Layers can be bound to separate storage, each is written on its own
+  bool written = std::fwrite(&header, sizeof(header), 1, file) == 1;
+  for (std::uint8_t layer = 0; layer < NUM_TILE_LAYERS && written; ++layer) {
+    written = std::fwrite(tile_map.layers[layer], sizeof(std::uint64_t), tile_map.layer_words(), file) ==
+              tile_map.layer_words();
+  }
+  written = written && std::fwrite(spawns.data(), sizeof(LevelBinarySpawn), spawns.size(), file) == spawns.size();
+
+  const std::uint64_t padding = header.file_size - header.spawns_offset - spawns.size() * sizeof(LevelBinarySpawn);
+  const std::uint8_t zeros[8] = {};
+  written = written && std::fwrite(zeros, 1, padding, file) == padding;
+  written = (std::fclose(file) == 0) && written;
+  return written ? LEVEL_ERROR::NONE : LEVEL_ERROR::CANT_WRITE;
+}
+
+// Copy-on-write mapping of the whole file, writes never reach the file
+static void* map_level_file(const char* path, std::size_t* size) {
+#if defined(_WIN32)
+  HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                            FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file == INVALID_HANDLE_VALUE) return nullptr;
+
+  LARGE_INTEGER file_size = {};
+  void* data = nullptr;
+  if (GetFileSizeEx(file, &file_size) && file_size.QuadPart > 0) {
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+    if (mapping) {
+      data = MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+      CloseHandle(mapping);
+    }
+  }
+  CloseHandle(file);
+  *size = static_cast<std::size_t>(file_size.QuadPart);
+  return data;
+#else
+  const int fd = open(path, O_RDONLY);
+  if (fd < 0) return nullptr;
+
+  struct stat st = {};
+  void* data = nullptr;
+  if (fstat(fd, &st) == 0 && st.st_size > 0) {
+    data = mmap(nullptr, static_cast<std::size_t>(st.st_size), PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED) data = nullptr;
+  }
+  close(fd);
+  *size = static_cast<std::size_t>(st.st_size);
+  return data;
+#endif
+}
+
+static void unmap_level_file(void* data, std::size_t size) {
+#if defined(_WIN32)
+  (void)size;
+  UnmapViewOfFile(data);
+#else
+  munmap(data, size);
+#endif
+}
+
+static bool is_level_header_valid(const LevelBinaryHeader& header, std::size_t size) {
+  if (std::memcmp(header.magic, LEVEL_BINARY_MAGIC, sizeof(header.magic)) != 0) return false;
+  if (header.version != LEVEL_BINARY_VERSION || header.file_size != size) return false;
+  if (header.cols == 0 || header.rows == 0 || header.cols > MAX_LEVEL_SIZE || header.rows > MAX_LEVEL_SIZE) return false;
+  if (header.words_per_row != (header.cols + 63u) / 64u || header.tile_size == 0) return false;
+  if (header.num_spawns == 0 || header.num_spawns > MAX_ENTITIES) return false;
+
+  const std::uint64_t tiles_size = std::uint64_t(NUM_TILE_LAYERS) * header.rows * header.words_per_row *
+                                   sizeof(std::uint64_t);
+  return header.tiles_offset % 8u == 0 && header.tiles_offset >= sizeof(LevelBinaryHeader) &&
+         header.tiles_offset + tiles_size <= size &&
+         header.spawns_offset >= header.tiles_offset + tiles_size &&
+         header.spawns_offset + std::uint64_t(header.num_spawns) * sizeof(LevelBinarySpawn) <= size;
+}
+
+LEVEL_ERROR open_mapped_level(MappedLevel* level, const char* path) {
+  close_mapped_level(level);
+
+  std::size_t size = 0;
+  void* data = map_level_file(path, &size);
+  if (!data) return LEVEL_ERROR::CANT_OPEN;
+
+  LevelBinaryHeader header = {};
+  if (size < sizeof(header)) {
+    unmap_level_file(data, size);
+    return LEVEL_ERROR::BAD_FORMAT;
+  }
+  std::memcpy(&header, data, sizeof(header));
+  if (!is_level_header_valid(header, size)) {
+    unmap_level_file(data, size);
+    return LEVEL_ERROR::BAD_FORMAT;
+  }
+
+  std::uint8_t* bytes = static_cast<std::uint8_t*>(data);
+  const LevelBinarySpawn* spawns = reinterpret_cast<const LevelBinarySpawn*>(bytes + header.spawns_offset);
+  for (std::uint32_t i = 0; i < header.num_spawns; ++i) {
+    const GHOST_TYPE expected_min = (i == 0) ? GHOST_TYPE::NONE : GHOST_TYPE::BLINKY;
+    const GHOST_TYPE expected_max = (i == 0) ? GHOST_TYPE::NONE : GHOST_TYPE::CLYDE;
+    const TilePos tile_pos = spawns[i].tile_pos;
+    if (spawns[i].type < expected_min || spawns[i].type > expected_max ||
+        tile_pos.col < 0 || tile_pos.row < 0 || tile_pos.col >= header.cols || tile_pos.row >= header.rows) {
+      unmap_level_file(data, size);
+      return LEVEL_ERROR::BAD_FORMAT;
+    }
+  }
+
+  // No allocation, the layers live in the mapping. A new mapping can land
+  // at the old one's address, so the layout version moves on for caches
+  // keyed on the layout storage (see DistanceFieldCache).
+  TileMap& tile_map = level->tile_map;
+  tile_map.tile_size = header.tile_size;
+  tile_map.rows = header.rows;
+  tile_map.cols = header.cols;
+  tile_map.layout_version = tile_map.layout_version + 1;
+  tile_map.words_per_row = header.words_per_row;
+  tile_map.bits.reset();
+  std::uint64_t* tiles = reinterpret_cast<std::uint64_t*>(bytes + header.tiles_offset);
+  for (std::uint8_t layer = 0; layer < NUM_TILE_LAYERS; ++layer) {
+    tile_map.layers[layer] = tiles + layer * tile_map.layer_words();
+  }
+  // The header's count isn't trusted, games end when it's reached
+  tile_map.all_dots = tile_map.count(TILE_TYPE::DOT);
+
+  level->entities = EntityStore{};
+  init_entity(&level->entities, PLAYER_ID, spawns[0].tile_pos, 0.15f); // movement speed of ~10 tiles/sec
+  std::vector<GhostSpawn> ghost_spawns;
+  for (std::uint32_t i = 1; i < header.num_spawns; ++i) {
+    ghost_spawns.push_back(GhostSpawn{ spawns[i].type, spawns[i].tile_pos });
+  }
+  add_ghost_spawns(&level->entities, &ghost_spawns);
+
+  level->has_pen = (header.flags & LEVEL_BINARY_HAS_PEN) != 0;
+  level->pen_door = header.pen_door;
+  level->pen_home = header.pen_home;
+  level->data = data;
+  level->size = size;
+  return LEVEL_ERROR::NONE;
+}
+
+void close_mapped_level(MappedLevel* level) {
+  if (level->data) unmap_level_file(level->data, level->size);
+  level->data = nullptr;
+  level->size = 0;
+  for (std::uint64_t*& layer : level->tile_map.layers) layer = nullptr;
+}
+
+LevelLoad load_level(const char* path, std::uint16_t tile_size) {
+  const std::size_t path_len = std::strlen(path);
+  if (path_len < 4 || std::strcmp(path + path_len - 4, ".pml") != 0) return load_level_file(path, tile_size);
+
+  LevelLoad load = {};
+  std::shared_ptr<MappedLevel> mapped(new MappedLevel{}, [](MappedLevel* level) {
+    close_mapped_level(level);
+    delete level;
+  });
+  load.error = open_mapped_level(mapped.get(), path);
+  if (!load.ok()) return load;
+
+  load.tile_map = std::make_unique<TileMap>();
+  load.tile_map->view_of(mapped->tile_map);
+  load.entities = std::make_unique<EntityStore>(mapped->entities);
+  load.has_pen = mapped->has_pen;
+  load.pen_door = mapped->pen_door;
+  load.pen_home = mapped->pen_home;
+  load.mapping = std::move(mapped);
+  return load;
+}
@@ -0,0 +1,76 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include "tile_map.h"
+#include "entity.h"
+#include "tile_pos.h"
+#include "level_file.h"
+
+// Compiled levels: a fixed header followed by the tile bitboards exactly as
+// TileMap stores them and the spawn points. Opening one maps the file
+// copy-on-write and points the map's layers into it, so loading costs page
+// faults instead of a parse, and eating dots only copies the pages touched.
+//
+// Layout (little endian, sections 8 byte aligned):
+//   LevelBinaryHeader
+//   tiles   NUM_TILE_LAYERS * rows * words_per_row u64, [layer][row][word]
+//   spawns  num_spawns LevelBinarySpawn, the player first
+constexpr char LEVEL_BINARY_MAGIC[4] = { 'P', 'M', 'L', 'V' };
+constexpr std::uint32_t LEVEL_BINARY_VERSION = 1;
+constexpr std::uint32_t LEVEL_BINARY_HAS_PEN = 1u << 0;
+
+struct LevelBinaryHeader {
+  char magic[4];
+  std::uint32_t version;
+  std::uint16_t cols;
+  std::uint16_t rows;
+  std::uint16_t words_per_row;
+  std::uint16_t tile_size;
+  std::uint32_t all_dots;
+  std::uint32_t flags;               // LEVEL_BINARY_HAS_PEN
+  TilePos pen_door;
+  TilePos pen_home;
+  std::uint32_t num_spawns;
+  std::uint32_t reserved;
+  std::uint64_t tiles_offset;
+  std::uint64_t spawns_offset;
+  std::uint64_t file_size;
+};
+static_assert(sizeof(LevelBinaryHeader) == 64, "the header is part of the file format");
+
+struct LevelBinarySpawn {
+  GHOST_TYPE type;                   // NONE for the player
+  std::uint8_t reserved;
+  TilePos tile_pos;
+};
+static_assert(sizeof(LevelBinarySpawn) == 6, "spawns are part of the file format");
+
+// The map and entities of a mapped level. tile_map's layers point into the
+// mapping, it stays valid until close_mapped_level(). Don't move it around
+// once open, like GameSim.
+struct MappedLevel {
+  void* data{nullptr};
+  std::size_t size{0};
+  TileMap tile_map{};
+  EntityStore entities{};
+  bool has_pen{false};
+  TilePos pen_door{};
+  TilePos pen_home{};
+};
+
+// Writes a level, e.g. one loaded with load_level_file(). The pen is
+// optional, pass nullptr for either to leave it out.
+LEVEL_ERROR save_level_binary(const char* path, const TileMap& tile_map, const EntityStore& entities,
+                              const TilePos* pen_door, const TilePos* pen_home);
+
+// Only the header and the spawns are checked, the tiles are trusted. The
+// dots are counted from the tiles, that reads the DOT layer.
+LEVEL_ERROR open_mapped_level(MappedLevel* level, const char* path);
+void close_mapped_level(MappedLevel* level);
+
+// Either kind of level, compiled ones by their .pml extension. A compiled
+// level stays mapped as long as the LevelLoad (or a copy of its mapping)
+// is around: its map's layers point into the mapping, nothing is copied or
+// parsed, and its pen comes from the header. bytes/seconds are only set
+// for text levels.
+LevelLoad load_level(const char* path, std::uint16_t tile_size);
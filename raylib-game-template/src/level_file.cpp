@@ -0,0 +1,248 @@
+#include "level_file.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include "level.h"
+
+static constexpr std::size_t LEVEL_READ_CHUNK = 64 * 1024;
+static constexpr std::size_t MAX_ROW_WORDS = (MAX_LEVEL_SIZE + 63u) / 64u;
+
+// Row being parsed, flushed into the layers when its line ends
+struct LevelRowParser {
+  std::uint32_t cols{0};                   // set by the first row
+  std::uint32_t row{0};
+  std::uint32_t col{0};
+  std::uint16_t words_per_row{0};
+  std::vector<std::uint64_t> row_bits;     // [layer][MAX_ROW_WORDS] of the current row
+  std::vector<std::uint64_t> layers[NUM_TILE_LAYERS];
+  std::vector<GhostSpawn> ghost_spawns;
+  TilePos player_pos{};
+  std::uint32_t num_players{0};
+  bool blank_line{false};                  // held back, only allowed as the last line
+  LEVEL_ERROR error{LEVEL_ERROR::NONE};
+};
+
+static bool set_level_error(LevelRowParser* parser, LEVEL_ERROR error) {
+  parser->error = error;
+  return false;
+}
+
+static bool end_level_row(LevelRowParser* parser) {
+  // Editors often leave an empty line at the end of the file, anything
+  // after it makes it a blank row
+  if (parser->blank_line) return set_level_error(parser, LEVEL_ERROR::RAGGED_ROWS);
+  if (parser->row > 0 && parser->col == 0) {
+    parser->blank_line = true;
+    return true;
+  }
+  if (parser->row == 0) {
+    if (parser->col == 0) return set_level_error(parser, LEVEL_ERROR::EMPTY);
+    parser->cols = parser->col;
+    parser->words_per_row = static_cast<std::uint16_t>((parser->cols + 63u) / 64u);
+  }
+  if (parser->col != parser->cols) return set_level_error(parser, LEVEL_ERROR::RAGGED_ROWS);
+  if (parser->row >= MAX_LEVEL_SIZE) return set_level_error(parser, LEVEL_ERROR::TOO_BIG);
+
+  // Bits past cols are never set, so only the row's own words need clearing
+  const std::uint16_t words_per_row = parser->words_per_row;
+  for (std::uint8_t layer = 0; layer < NUM_TILE_LAYERS; ++layer) {
+    std::uint64_t* row_words = &parser->row_bits[layer * MAX_ROW_WORDS];
+    parser->layers[layer].insert(parser->layers[layer].end(), row_words, row_words + words_per_row);
+    std::fill(row_words, row_words + words_per_row, 0);
+  }
+
+  ++parser->row;
+  parser->col = 0;
+  return true;
+}
+
+// What each character is: a TILE_TYPE value, a spawn marker or an error
+static constexpr std::uint8_t LEVEL_CHAR_SPAWN = NUM_TILE_LAYERS + 1;
+static constexpr std::uint8_t LEVEL_CHAR_SKIP = NUM_TILE_LAYERS + 2;
+static constexpr std::uint8_t LEVEL_CHAR_BAD = NUM_TILE_LAYERS + 3;
+
+struct LevelCharCodes {
+  std::uint8_t codes[256];
+
+  constexpr LevelCharCodes() : codes{} {
+    for (std::uint8_t& code : codes) code = LEVEL_CHAR_BAD;
+    codes[static_cast<std::uint8_t>(' ')] = static_cast<std::uint8_t>(TILE_TYPE::EMPTY);
+    codes[static_cast<std::uint8_t>('#')] = static_cast<std::uint8_t>(TILE_TYPE::WALL);
+    codes[static_cast<std::uint8_t>('-')] = static_cast<std::uint8_t>(TILE_TYPE::DOOR);
+    codes[static_cast<std::uint8_t>('.')] = static_cast<std::uint8_t>(TILE_TYPE::DOT);
+    codes[static_cast<std::uint8_t>('O')] = static_cast<std::uint8_t>(TILE_TYPE::PILL);
+    codes[static_cast<std::uint8_t>('=')] = static_cast<std::uint8_t>(TILE_TYPE::TELEPORT);
+    codes[static_cast<std::uint8_t>('P')] = LEVEL_CHAR_SPAWN;
+    codes[static_cast<std::uint8_t>('B')] = LEVEL_CHAR_SPAWN;
+    codes[static_cast<std::uint8_t>('K')] = LEVEL_CHAR_SPAWN;
+    codes[static_cast<std::uint8_t>('I')] = LEVEL_CHAR_SPAWN;
+    codes[static_cast<std::uint8_t>('C')] = LEVEL_CHAR_SPAWN;
+    codes[static_cast<std::uint8_t>('\r')] = LEVEL_CHAR_SKIP;
+  }
+};
+static constexpr LevelCharCodes LEVEL_CHAR_CODES{};
+
+static void add_level_spawn(LevelRowParser* parser, char ch, std::uint32_t col) {
+  const TilePos tile_pos = { static_cast<std::int16_t>(col), static_cast<std::int16_t>(parser->row) };
+  switch (ch) {
+  case 'P': {
+    parser->player_pos = tile_pos;
+    ++parser->num_players;
+  } break;
+  case 'B': parser->ghost_spawns.push_back({ GHOST_TYPE::BLINKY, tile_pos }); break;
+  case 'K': parser->ghost_spawns.push_back({ GHOST_TYPE::PINKY, tile_pos }); break;
+  case 'I': parser->ghost_spawns.push_back({ GHOST_TYPE::INKY, tile_pos }); break;
+  case 'C': parser->ghost_spawns.push_back({ GHOST_TYPE::CLYDE, tile_pos }); break;
+  default: break;
+  }
+}
+
+// Adds the word's bits gathered per tile code to the row, code 0 (EMPTY)
+// has no layer
+static void flush_level_word(LevelRowParser* parser, std::uint64_t (&words)[NUM_TILE_LAYERS + 1],
+                             std::uint32_t word) {
+  for (std::uint8_t layer = 0; layer < NUM_TILE_LAYERS; ++layer) {
+    parser->row_bits[layer * MAX_ROW_WORDS + word] |= words[layer + 1];
+    words[layer + 1] = 0;
+  }
+}
+
+// Part of a row, up to its line break. Bits are gathered a word at a time.
+static bool parse_level_span(LevelRowParser* parser, const char* begin, const char* end) {
+  const std::uint32_t max_cols = (parser->row > 0) ? parser->cols : MAX_LEVEL_SIZE;
+  std::uint64_t words[NUM_TILE_LAYERS + 1] = {};
+  std::uint32_t col = parser->col;
+
+  for (const char* ch = begin; ch != end; ++ch) {
+    const std::uint8_t code = LEVEL_CHAR_CODES.codes[static_cast<std::uint8_t>(*ch)];
+    if (code > NUM_TILE_LAYERS) {
+      if (code == LEVEL_CHAR_SKIP) continue;
+      if (code == LEVEL_CHAR_BAD) return set_level_error(parser, LEVEL_ERROR::BAD_TILE);
+    }
+    if (parser->blank_line) return set_level_error(parser, LEVEL_ERROR::RAGGED_ROWS);
+    if (col >= max_cols) {
+      return set_level_error(parser, (parser->row > 0) ? LEVEL_ERROR::RAGGED_ROWS : LEVEL_ERROR::TOO_BIG);
+    }
+
+    if (code == LEVEL_CHAR_SPAWN) {
+      add_level_spawn(parser, *ch, col);
+    } else {
+      words[code] |= std::uint64_t(1) << (col & 63u);
+    }
+    if ((col & 63u) == 63u) flush_level_word(parser, words, col >> 6);
+    ++col;
+  }
+  if (col & 63u) flush_level_word(parser, words, col >> 6);
+
+  parser->col = col;
+  return true;
+}
+
+LevelLoad load_level_file(const char* path, std::uint16_t tile_size) {
+  LevelLoad load = {};
+  const auto start = std::chrono::steady_clock::now();
+
+  std::FILE* file = std::fopen(path, "rb");
+  if (!file) {
+    load.error = LEVEL_ERROR::CANT_OPEN;
+    return load;
+  }
+
+  // Wide enough for any row, the width isn't known before the first one ends
+  LevelRowParser parser = {};
+  parser.row_bits.assign(NUM_TILE_LAYERS * MAX_ROW_WORDS, 0);
+
+  std::vector<char> chunk(LEVEL_READ_CHUNK);
+  bool parsing = true;
+  while (parsing) {
+    const std::size_t num_read = std::fread(chunk.data(), 1, chunk.size(), file);
+    load.bytes += num_read;
+    if (num_read == 0) break;
+
+    // Rows can straddle chunks, the parser carries on where it stopped
+    const char* begin = chunk.data();
+    const char* end = begin + num_read;
+    while (parsing && begin != end) {
+      const char* line_end = static_cast<const char*>(std::memchr(begin, '\n', static_cast<std::size_t>(end - begin)));
+      if (!line_end) {
+        parsing = parse_level_span(&parser, begin, end);
+        break;
+      }
+      parsing = parse_level_span(&parser, begin, line_end) && end_level_row(&parser);
+      begin = line_end + 1;
+    }
+  }
+  std::fclose(file);
+
+  // The last line doesn't need a line break
+  if (parsing && parser.col > 0) parsing = end_level_row(&parser);
+
+  if (parsing) {
+    if (parser.row == 0) parser.error = LEVEL_ERROR::EMPTY;
+    else if (parser.num_players == 0) parser.error = LEVEL_ERROR::NO_PLAYER;
+    else if (parser.num_players > 1) parser.error = LEVEL_ERROR::MANY_PLAYERS;
+    else if (parser.ghost_spawns.size() >= MAX_ENTITIES) parser.error = LEVEL_ERROR::MANY_GHOSTS;
+  } else {
+    load.error_line = parser.row + 1;
+  }
+  load.error = parser.error;
+  if (!load.ok()) return load;
+
+  auto map = std::make_unique<TileMap>();
+  map->tile_size = tile_size;
+  map->all_dots = 0;
+  map->layout_version = 1;
+  map->allocate(static_cast<std::uint16_t>(parser.cols), static_cast<std::uint16_t>(parser.row));
+  for (std::uint8_t layer = 0; layer < NUM_TILE_LAYERS; ++layer) {
+    std::copy(parser.layers[layer].begin(), parser.layers[layer].end(), map->layers[layer]);
+  }
+  const std::uint64_t* dots = map->layer_row(TILE_TYPE::DOT, 0);
+  for (std::size_t i = 0; i < map->layer_words(); ++i) {
+    map->all_dots += popcount64(dots[i]);
+  }
+
+  auto entities = std::make_unique<EntityStore>();
+  init_entity(entities.get(), PLAYER_ID, parser.player_pos, 0.15f); // movement speed of ~10 tiles/sec
+  add_ghost_spawns(entities.get(), &parser.ghost_spawns);
+
+  load.tile_map = std::move(map);
+  load.entities = std::move(entities);
+  load.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  load.has_pen = find_level_pen(*load.tile_map, &load.pen_door, &load.pen_home);
+  return load;
+}
+
+static_assert(MAX_LEVEL_SIZE == 32767, "TOO_BIG's message names the limit");
+
+const char* get_level_error_name(LEVEL_ERROR error) {
+  switch (error) {
+  case LEVEL_ERROR::NONE:         return "ok";
+  case LEVEL_ERROR::CANT_OPEN:    return "can't open file";
+  case LEVEL_ERROR::EMPTY:        return "empty level";
+  case LEVEL_ERROR::RAGGED_ROWS:  return "rows of different lengths";
+  case LEVEL_ERROR::TOO_BIG:      return "level too big, 32767x32767 tiles at most";
+  case LEVEL_ERROR::BAD_TILE:     return "unknown tile character";
+  case LEVEL_ERROR::NO_PLAYER:    return "no player spawn";
+  case LEVEL_ERROR::MANY_PLAYERS: return "more than one player spawn";
+  case LEVEL_ERROR::MANY_GHOSTS:  return "too many ghosts";
+  case LEVEL_ERROR::BAD_FORMAT:   return "not a compiled level";
+  case LEVEL_ERROR::CANT_WRITE:   return "can't write file";
+  default:                        return "unknown error";
+  }
+}
+
+bool find_level_pen(const TileMap& tile_map, TilePos* pen_door, TilePos* pen_home) {
+  for (std::uint16_t row = 1; row + 2 < tile_map.rows; ++row) {
+    const std::uint64_t* doors = tile_map.layer_row(TILE_TYPE::DOOR, row);
+    for (std::uint16_t word = 0; word < tile_map.words_per_row; ++word) {
+      if (!doors[word]) continue;
+
+      const std::int16_t col = static_cast<std::int16_t>(word * 64u + ctz64(doors[word]));
+      *pen_door = TilePos{ col, static_cast<std::int16_t>(row - 1) };
+      *pen_home = TilePos{ col, static_cast<std::int16_t>(row + 2) };
+      return true;
+    }
+  }
+  return false;
+}
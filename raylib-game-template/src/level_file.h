@@ -0,0 +1,55 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include "tile_map.h"
+#include "entity.h"
+#include "tile_pos.h"
+
+// Text levels loaded at runtime, same characters as parse_level() (see
+// level.h): '#' wall, '-' door, '.' dot, 'O' pill, '=' teleport, ' ' empty,
+// 'P' the player and 'B'/'K'/'I'/'C' the ghosts. One row per line, '\r' is
+// ignored so files saved on Windows load too.
+//
+// The file is read in fixed size chunks and each row goes straight into
+// the bitboards, so big mazes don't cost a string per line.
+enum class LEVEL_ERROR : std::uint8_t {
+  NONE = 0,
+  CANT_OPEN,
+  EMPTY,
+  RAGGED_ROWS,       // a row isn't as long as the first one
+  TOO_BIG,           // more than MAX_LEVEL_SIZE rows or columns
+  BAD_TILE,          // a character that isn't a tile or spawn marker
+  NO_PLAYER,
+  MANY_PLAYERS,
+  MANY_GHOSTS,       // more than MAX_ENTITIES - 1
+  BAD_FORMAT,        // not a compiled level or a damaged one, see level_binary.h
+  CANT_WRITE,
+};
+
+// TilePos is 16-bit signed
+constexpr std::uint32_t MAX_LEVEL_SIZE = 0x7fff;
+
+struct LevelLoad {
+  std::unique_ptr<TileMap> tile_map;       // null on errors
+  std::unique_ptr<EntityStore> entities;
+  std::shared_ptr<void> mapping;           // what tile_map points into, if it doesn't own its layers
+  LEVEL_ERROR error{LEVEL_ERROR::NONE};
+  std::uint32_t error_line{0};             // 1-based, 0 if not about a line
+  bool has_pen{false};                     // see find_level_pen()
+  TilePos pen_door{};
+  TilePos pen_home{};
+  std::uint64_t bytes{0};
+  double seconds{0.0};                     // reading and parsing
+
+  bool ok() const { return error == LEVEL_ERROR::NONE; }
+};
+
+LevelLoad load_level_file(const char* path, std::uint16_t tile_size);
+const char* get_level_error_name(LEVEL_ERROR error);
+
+// The pen is found from the first door tile in reading order: ghosts leave
+// through the tile above it and go home two tiles below it. For the classic
+// maze that's CLASSIC_PEN_DOOR/CLASSIC_PEN_HOME. Doors in the first row or
+// the last two are skipped, their exit or home would be off the map.
+// Returns false without a usable door.
+bool find_level_pen(const TileMap& tile_map, TilePos* pen_door, TilePos* pen_home);
@@ -1,267 +1,262 @@
+#include <algorithm>
 #include <cstdint>
-#include <array>
-#include <string>
+#include <cstring>
+#include <ctime>
 #include <memory>
+#include <tuple>
 
 #include "raylib.h"
 #include "level.h"
+#include "level_file.h"
+#include "level_binary.h"
+#include "classic_level.h"
 #include "movement_dir.h"
 #include "entity.h"
 #include "tile_map.h"
-#include "player.h"
 #include "ghosts.h"
+#include "sim.h"
+#include "game_state.h"
+#include "game_sim.h"
+#include "replay.h"
+#include "profiler.h"
+#include "render.h"
 
-static void check_and_resolve_entity_collisions(Entities* entities);
-
-static void draw_map_and_entities(const TileMap& tile_map, Entities* entities,
-                                  GHOST_STATE curr_ghost_state, float dt);
+// Mazes bigger than this scroll with the player, see get_follow_camera
+static constexpr std::uint32_t MAX_SCREEN_WIDTH = 1280;
+static constexpr std::uint32_t MAX_SCREEN_HEIGHT = 960;
 
 static void draw_end_game_text(const char* msg,
                                std::uint32_t screen_width,
                                std::uint32_t screen_height);
-int main(void) {
-  // The tile map variables, tile map itself and scatter/chase schedules
-  // are all placed here for convenience. Ultimately, they can be taken out
-  // into a level/map file
-  const std::uint16_t tile_size = 24;
-  const std::uint16_t num_tiles_x = 28;
-  const std::uint16_t num_tiles_y = 36;
-  const std::uint32_t screen_width = num_tiles_x * tile_size;
-  const std::uint32_t screen_height = num_tiles_y * tile_size;
-
-  std::array<std::string, num_tiles_y> level = {
-    "                            ",
-	"                            ",
-	"                            ",
-	"############################",
-	"#............##............#",
-	"#.####.#####.##.#####.####.#",
-	"#O####.#####.##.#####.####O#",
-	"#.####.#####.##.#####.####.#",
-	"#..........................#",
-	"#.####.##.########.##.####.#",
-	"#.####.##.########.##.####.#",
-	"#......##....##....##......#",
-	"######.##### ## #####.######",
-	"     #.##### ## #####.#     ",
-	"     #.##    B     ##.#     ",
-	"     #.## ###--### ##.#     ",
-	"######.## #      # ##.######",
-	"=     .   #I K C #   .     =",
-	"######.## #      # ##.######",
-	"     #.## ######## ##.#     ",
-	"     #.##          ##.#     ",
-	"     #.## ######## ##.#     ",
-	"######.## ######## ##.######",
-	"#............##............#",
-	"#.####.#####.##.#####.####.#",
-	"#.####.#####.##.#####.####.#",
-	"#O..##.......P .......##..O#",
-	"###.##.##.########.##.##.###",
-	"###.##.##.########.##.##.###",
-	"#......##....##....##......#",
-	"#.##########.##.##########.#",
-	"#.##########.##.##########.#",
-	"#..........................#",
-	"############################",
-	"                            ",
-	"                            "
-  };
-
-  // Ghosts time schedule for scattering and chasing, in seconds
-  constexpr double scatter_schedule[4] = {7.0, 7.0, 5.0, 5.0};
-  constexpr double chase_schedule[4]   = {20.0, 20.0, 20.0,
-                                          std::numeric_limits<double>::infinity()};
+// Usage: pacman [--level level_path] [replay_path]
+// With a replay path, the session's inputs are recorded there on exit (see
+// replay.h). A level path plays that text level (see level_file.h) or
+// compiled .pml level (see level_binary.h) instead of the classic maze.
+int main(int argc, char** argv) {
+  const char* level_path = nullptr;
+  const char* replay_path = nullptr;
+  for (int arg = 1; arg < argc; ++arg) {
+    if (std::strcmp(argv[arg], "--level") == 0 && arg + 1 < argc) {
+      level_path = argv[++arg];
+    } else {
+      replay_path = argv[arg];
+    }
+  }
+
+  // The classic maze and its scatter/chase schedules live in classic_level.h,
+  // shared with the headless simulation driver
+  const std::uint16_t tile_size = CLASSIC_TILE_SIZE;
+  GameSimConfig sim_config = {};
+
+  // Kept for the whole session, the game plays on the level's own walls
+  // (for compiled levels, straight out of their mapping, see load_level())
+  LevelLoad level = {};
+  if (level_path) {
+    level = load_level(level_path, tile_size);
+    if (!level.ok()) {
+      TraceLog(LOG_ERROR, "%s: %s (line %u)", level_path, get_level_error_name(level.error), level.error_line);
+      return 1;
+    }
+    TraceLog(LOG_INFO, "%s: %ux%u tiles loaded in %.3f ms", level_path, level.tile_map->cols,
+             level.tile_map->rows, level.seconds * 1e3);
+    if (level.has_pen) {
+      sim_config.pen_door = level.pen_door;
+      sim_config.pen_home = level.pen_home;
+    }
+  } else {
+    std::tie(level.tile_map, level.entities) = parse_level(get_classic_level(), tile_size);
+  }
+  const TileMap& level_map = *level.tile_map;
+  const std::uint32_t screen_width = std::min<std::uint32_t>(level_map.cols * tile_size, MAX_SCREEN_WIDTH);
+  const std::uint32_t screen_height = std::min<std::uint32_t>(level_map.rows * tile_size, MAX_SCREEN_HEIGHT);
 
   // Init
   InitWindow(screen_width, screen_height, "Pacman");
   SetTargetFPS(60);
-  auto [tile_map_ptr, entities_ptr] = parse_level(level, tile_size);
+
+  // The same forward model the headless tools use, see game_sim.h. The
+  // game's state lives apart from the level's fixed data.
+  auto sim = std::make_unique<GameSim>();
+  if (!init_game_sim_shared(sim.get(), level_map, *level.entities, sim_config)) {
+    TraceLog(LOG_ERROR, "The level is %ux%u tiles, a game can't be bigger than %ux%u",
+             level_map.cols, level_map.rows, MAX_GAME_STATE_SIZE, MAX_GAME_STATE_SIZE);
+    CloseWindow();
+    return 1;
+  }
+  const std::uint64_t seed = static_cast<std::uint64_t>(time(nullptr));
+  // Levels bigger than 64x64 keep their dots/pills in layers
+  auto state = std::make_unique<GameState>();
+  GameLayers layers = {};
+  sim->reset(state.get(), seed, 0, &layers);
+  sim->bind(state.get(), &layers);
+
+  // Everything needed to play the session again, see replay.h
+  Replay replay = {};
+  replay.seed = seed;
+  replay.level_hash = sim->initial_state.hash;
+  if (level_path) replay.level_path = level_path;
+  std::uint64_t sim_ticks = 0;
 
   // Using these locals to avoid dereferencing syntax
-  TileMap& tile_map = *tile_map_ptr;
-  Entities& entities = *entities_ptr;
-
-  // Init ghosts state machine
-  GhostsStateMachine ghosts_sm = {};
-  GhostContext ghost_ctx{
-    tile_map,
-    ghosts_sm,
-    entities.player,
-    entities.blinky,
-    {13,14}, // pen door
-    {13,17}  // pen home
-  };
+  const TileMap& tile_map = sim->tile_map;
+  EntityStore& entities = state->entities;
+  const GhostsStateMachine& ghosts_sm = state->ghosts_sm;
+
+  // Textures and animation state, kept apart from the simulation
+  auto render_store = std::make_unique<EntityRenderStore>();
+  load_entities_textures(render_store.get(), entities);
+
+  // The maze is baked into render textures, see MapRenderCache. Only the
+  // chunks the camera sees are baked and drawn.
+  MapRenderCache map_cache = {};
+  Camera2D camera = {};
+  Rectangle view = {};
+
+  // Rendering runs at the display rate, gameplay at SIM_TICK_RATE
+  FixedStepClock sim_clock = {};
+
+  // Always recording, F3 shows the last frame's breakdown and F4 saves the
+  // recent frames as a Chrome trace (see profiler.h)
+  auto profiler = std::make_unique<FrameProfiler>();
+  sim->profiler = profiler.get();
 
   // Detects window close button or ESC key
   while (!WindowShouldClose()) {
+    ProfileScope frame_scope(profiler.get(), "frame");
     const float dt = GetFrameTime();
 
+    if (IsKeyPressed(KEY_F3)) profiler->show_overlay = !profiler->show_overlay;
+    if (IsKeyPressed(KEY_F4) && !export_chrome_trace(*profiler, "pacman_trace.json")) {
+      TraceLog(LOG_WARNING, "Could not save pacman_trace.json");
+    }
+
+    const GAME_STATUS status = get_game_status(tile_map, entities);
+
     // Win condition
-    if (entities.player.collected_dots >= tile_map.all_dots) {
+    if (status == GAME_STATUS::WON) {
+      camera = get_follow_camera(tile_map, get_entity_draw_pos(tile_map, entities, PLAYER_ID, sim_clock.remainder()),
+                                 screen_width, screen_height);
+      view = get_camera_view(camera, screen_width, screen_height);
+      sync_map_render_cache(&map_cache, tile_map, &view);
       BeginDrawing();
       ClearBackground(RAYWHITE);
-      draw_map_and_entities(tile_map, &entities, ghosts_sm.state, dt);
-      DrawText(TextFormat("SCORE: %i", entities.player.collected_dots),
+      BeginMode2D(camera);
+      draw_map_and_entities(tile_map, entities, render_store.get(), &map_cache, ghosts_sm.state,
+                            dt, sim_clock.remainder(), profiler.get());
+      EndMode2D();
+      DrawText(TextFormat("SCORE: %i", entities.collected_dots),
                10, 10, 20, MAROON);
 
       const char *msg = "YOU WON!";
       draw_end_game_text(msg, screen_width, screen_height);
+      if (profiler->show_overlay) draw_profiler_overlay(*profiler, screen_width - 264, 8);
 
+      ProfileScope end_drawing_scope(profiler.get(), "end_drawing");
       EndDrawing();
       continue;
     }
 
     // Lose condition   
-    if (entities.player.is_dead) {
+    if (status == GAME_STATUS::LOST) {
+      camera = get_follow_camera(tile_map, get_entity_draw_pos(tile_map, entities, PLAYER_ID, sim_clock.remainder()),
+                                 screen_width, screen_height);
+      view = get_camera_view(camera, screen_width, screen_height);
+      sync_map_render_cache(&map_cache, tile_map, &view);
       BeginDrawing();
       ClearBackground(RAYWHITE);
+      BeginMode2D(camera);
 
-      draw_map_and_entities(tile_map, &entities, ghosts_sm.state, dt);
-      DrawText(TextFormat("SCORE: %i", entities.player.collected_dots),
+      draw_map_and_entities(tile_map, entities, render_store.get(), &map_cache, ghosts_sm.state,
+                            dt, sim_clock.remainder(), profiler.get());
+      EndMode2D();
+      DrawText(TextFormat("SCORE: %i", entities.collected_dots),
                10, 10, 20, MAROON);
 
       const char *msg = "YOU LOST!";
       draw_end_game_text(msg, screen_width, screen_height);
+      if (profiler->show_overlay) draw_profiler_overlay(*profiler, screen_width - 264, 8);
 
+      ProfileScope end_drawing_scope(profiler.get(), "end_drawing");
       EndDrawing();
       continue;
     }
 
     // Gameplay loop
-    if (IsKeyPressed(KEY_UP)) {
-      entities.player.next_dir = MOVEMENT_DIR::UP;
-    }
-  
-    if (IsKeyPressed(KEY_DOWN)) {
-      entities.player.next_dir = MOVEMENT_DIR::DOWN;
-    }
-  
-    if (IsKeyPressed(KEY_RIGHT)) { 
-      entities.player.next_dir = MOVEMENT_DIR::RIGHT;
-    }
-  
-    if (IsKeyPressed(KEY_LEFT)) {
-      entities.player.next_dir = MOVEMENT_DIR::LEFT;
+    {
+      ProfileScope scope(profiler.get(), "input");
+      if (IsKeyPressed(KEY_UP)) {
+        entities.next_dir[PLAYER_ID] = MOVEMENT_DIR::UP;
+        record_replay_input(&replay, sim_ticks, MOVEMENT_DIR::UP);
+      }
+
+      if (IsKeyPressed(KEY_DOWN)) {
+        entities.next_dir[PLAYER_ID] = MOVEMENT_DIR::DOWN;
+        record_replay_input(&replay, sim_ticks, MOVEMENT_DIR::DOWN);
+      }
+
+      if (IsKeyPressed(KEY_RIGHT)) {
+        entities.next_dir[PLAYER_ID] = MOVEMENT_DIR::RIGHT;
+        record_replay_input(&replay, sim_ticks, MOVEMENT_DIR::RIGHT);
+      }
+
+      if (IsKeyPressed(KEY_LEFT)) {
+        entities.next_dir[PLAYER_ID] = MOVEMENT_DIR::LEFT;
+        record_replay_input(&replay, sim_ticks, MOVEMENT_DIR::LEFT);
+      }
     }
 
-    // Checks and resolves previous frames collisions. Doing it here
-    // prevents visual artifacts on collisions, due to the interpolation
-    // that's happening after an entity moves to a new tile.
-    check_and_resolve_entity_collisions(&entities);
+    {
+      ProfileScope scope(profiler.get(), "simulation");
+      const std::uint32_t ticks = sim_clock.advance(dt);
+      for (std::uint32_t tick = 0; tick < ticks; ++tick) {
+        const StepResult result = sim->step(state.get(), MOVEMENT_DIR::STOPPED, SIM_TICK_DT, &layers);
+        ++sim_ticks;
+        if (result.status != GAME_STATUS::PLAYING) break;
+      }
+    }
 
-    update_player(&tile_map, &entities.player, dt);
-    update_ghosts_global_sm(&ghosts_sm, entities.player.is_energized,
-                            scatter_schedule, chase_schedule, dt);
-    update_ghost(&entities.blinky, GHOST_TYPE::BLINKY, ghost_ctx, dt);
-    update_ghost(&entities.pinky,  GHOST_TYPE::PINKY, ghost_ctx, dt);
-    update_ghost(&entities.inky,   GHOST_TYPE::INKY, ghost_ctx, dt);
-    update_ghost(&entities.clyde,  GHOST_TYPE::CLYDE, ghost_ctx, dt);
+    {
+      ProfileScope scope(profiler.get(), "map_cache");
+      camera = get_follow_camera(tile_map, get_entity_draw_pos(tile_map, entities, PLAYER_ID, sim_clock.remainder()),
+                                 screen_width, screen_height);
+      view = get_camera_view(camera, screen_width, screen_height);
+      sync_map_render_cache(&map_cache, tile_map, &view);
+    }
 
     BeginDrawing();
 
     ClearBackground(RAYWHITE);
 
-    draw_map_and_entities(tile_map, &entities, ghosts_sm.state, dt);
+    // The HUD stays on screen, outside the camera
+    BeginMode2D(camera);
+    draw_map_and_entities(tile_map, entities, render_store.get(), &map_cache, ghosts_sm.state,
+                            dt, sim_clock.remainder(), profiler.get());
+    EndMode2D();
 
-    DrawText(TextFormat("SCORE: %i", entities.player.collected_dots),
-             10, 10, 20, MAROON);
-    
+    {
+      ProfileScope scope(profiler.get(), "hud");
+      DrawText(TextFormat("SCORE: %i", entities.collected_dots),
+               10, 10, 20, MAROON);
+      if (profiler->show_overlay) draw_profiler_overlay(*profiler, screen_width - 264, 8);
+    }
+
+    // Swaps buffers, waits for the frame limiter and polls input
+    ProfileScope end_drawing_scope(profiler.get(), "end_drawing");
     EndDrawing();
   }
 
+  if (replay_path) {
+    finish_replay(&replay, sim_ticks, *state);
+    if (!save_replay(replay, replay_path)) TraceLog(LOG_WARNING, "Could not save replay to %s", replay_path);
+  }
+
   // cleanup
+  unload_map_render_cache(&map_cache);
+  unload_entities_textures(render_store.get());
   CloseWindow();
   return 0;
 }
 
-static void check_and_resolve_entity_collisions(Entities* entities) {
-  Entity* player = &entities->player;
-  Entity* ghosts[] = { &entities->blinky, &entities->pinky,
-                       &entities->inky, &entities->clyde };
-
-  for (Entity* ghost : ghosts) {
-    if (ghost->is_dead) continue;
-
-    if (entity_collision(*player, *ghost)) {
-      if (player->is_energized) {
-        ghost->is_dead = true;
-      } else {
-        player->is_dead = true;
-        return;
-      }
-    }
-  }
-}
-
-static void draw_map_and_entities(const TileMap& tile_map, Entities* entities,
-                                  GHOST_STATE curr_ghost_state, float dt) {
-  const std::uint16_t tile_size = tile_map.tile_size;
-  const std::uint16_t total_rows = tile_map.rows;
-  const std::uint16_t total_cols = tile_map.cols;
-  const std::size_t total_tiles = static_cast<std::size_t>(total_rows) * total_cols;
-  const TILE_TYPE* tile_data = tile_map.tiles.get();
-
-  // Screen-space coordinates
-  int pixel_x = 0;
-  int pixel_y = 0;
-  int pixel_center_x = tile_size / 2;
-  int pixel_center_y = tile_size / 2;
-  std::uint16_t current_col = 0;
-
-  for (std::size_t tile_index = 0; tile_index < total_tiles; ++tile_index) {
-    TILE_TYPE current_tile = tile_data[tile_index];
-
-    if (current_tile == TILE_TYPE::WALL) {
-      DrawRectangle(pixel_x, pixel_y, tile_size, tile_size, GREEN);
-    }
-    else if (current_tile == TILE_TYPE::DOT) {
-      DrawCircle(pixel_center_x, pixel_center_y, 3, MAROON);
-    }
-    else if (current_tile == TILE_TYPE::PILL) {
-      DrawCircle(pixel_center_x, pixel_center_y, 8, MAROON);
-    }
-
-    // Advance column/pixel without division to get the tile center
-    pixel_x += tile_size;
-    pixel_center_x += tile_size;
-    ++current_col;
-
-    if (current_col == total_cols) {
-      current_col = 0;
-      pixel_x = 0;
-      pixel_center_x = tile_size / 2;
-      pixel_y += tile_size;
-      pixel_center_y += tile_size;
-    }
-  }
-
-  // We use WHITE tint when we don't want any tint
-  render_entity(tile_map, &entities->player, WHITE, dt);
-
-  // Get a color with  30% opacity, for ghosts when dead
-  Color dead_ghost_tint = WHITE;
-  dead_ghost_tint.a = static_cast<unsigned char>(255 * 0.3f);
-
-  Entity* ghosts[] = {
-    &entities->blinky,
-    &entities->pinky,
-    &entities->inky,
-    &entities->clyde
-  };
-
-  for (Entity* ghost : ghosts) {
-    Color tint = WHITE;
-    if (ghost->is_dead) {
-      tint = dead_ghost_tint;
-    } else if (curr_ghost_state == GHOST_STATE::FRIGHTENED) {
-      tint = DARKBLUE;
-    }
-
-    render_entity(tile_map, ghost, tint, dt);
-  }
-}
-
 static void draw_end_game_text(const char* msg,
                                std::uint32_t screen_width,
                                std::uint32_t screen_height) {
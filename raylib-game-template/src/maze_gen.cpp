@@ -0,0 +1,281 @@
+#include "maze_gen.h"
+#include <algorithm>
+#include <tuple>
+#include "level.h"
+#include "level_file.h"
+#include "sim_random.h"
+
+enum class CELL_KIND : std::uint8_t {
+  MAZE = 0,
+  RING,          // the corridor around the pen, carved up front
+  PEN,           // inside the ring, never carved
+};
+
+// Cell (col, row) is tile (2 * col + 1, 2 * row + 1), the walls between
+// cells are the tiles in between
+struct MazeGrid {
+  std::uint32_t cell_cols;
+  std::uint32_t cell_rows;
+  std::vector<std::string> lines;
+  std::vector<CELL_KIND> kinds;
+  std::vector<std::uint8_t> visited;
+
+  std::size_t cell(std::uint32_t col, std::uint32_t row) const { return std::size_t(row) * cell_cols + col; }
+  char& tile(std::uint32_t col, std::uint32_t row) { return lines[row][col]; }
+  char& cell_tile(std::uint32_t col, std::uint32_t row) { return tile(2 * col + 1, 2 * row + 1); }
+  // The wall between a cell and its neighbour at (col + dcol, row + drow)
+  char& wall_tile(std::uint32_t col, std::uint32_t row, int dcol, int drow) {
+    return tile(static_cast<std::uint32_t>(2 * static_cast<int>(col) + 1 + dcol),
+                static_cast<std::uint32_t>(2 * static_cast<int>(row) + 1 + drow));
+  }
+};
+
+static constexpr int CELL_STEPS[4][2] = { { 0, -1 }, { 0, 1 }, { -1, 0 }, { 1, 0 } };
+
+static bool is_cell_in_grid(const MazeGrid& grid, int col, int row) {
+  return col >= 0 && row >= 0 && col < static_cast<int>(grid.cell_cols) && row < static_cast<int>(grid.cell_rows);
+}
+
+// Walls can only come down between maze cells, or between the maze and the
+// ring around the pen
+static bool can_join_cells(const MazeGrid& grid, std::uint32_t col, std::uint32_t row, int dcol, int drow) {
+  const int next_col = static_cast<int>(col) + dcol;
+  const int next_row = static_cast<int>(row) + drow;
+  if (!is_cell_in_grid(grid, next_col, next_row)) return false;
+
+  const CELL_KIND kind = grid.kinds[grid.cell(col, row)];
+  const CELL_KIND next_kind = grid.kinds[grid.cell(static_cast<std::uint32_t>(next_col), static_cast<std::uint32_t>(next_row))];
+  if (kind == CELL_KIND::PEN || next_kind == CELL_KIND::PEN) return false;
+  return kind == CELL_KIND::MAZE || next_kind == CELL_KIND::MAZE;
+}
+
+static void shuffle_steps(SimRandom* random, int (&order)[4]) {
+  for (int i = 3; i > 0; --i) std::swap(order[i], order[get_sim_random_value(random, 0, i)]);
+}
+
+// Randomized depth first search over the maze cells, with its own stack so
+// huge mazes don't overflow the call stack
+static void carve_corridors(MazeGrid* grid, SimRandom* random, std::uint32_t start_col, std::uint32_t start_row) {
+  std::vector<std::uint32_t> stack;
+  stack.push_back(static_cast<std::uint32_t>(grid->cell(start_col, start_row)));
+  grid->visited[stack.back()] = 1;
+  grid->cell_tile(start_col, start_row) = '.';
+
+  while (!stack.empty()) {
+    const std::uint32_t current = stack.back();
+    const std::uint32_t col = current % grid->cell_cols;
+    const std::uint32_t row = current / grid->cell_cols;
+
+    int order[4] = { 0, 1, 2, 3 };
+    shuffle_steps(random, order);
+    bool moved = false;
+    for (int step : order) {
+      const int next_col = static_cast<int>(col) + CELL_STEPS[step][0];
+      const int next_row = static_cast<int>(row) + CELL_STEPS[step][1];
+      if (!is_cell_in_grid(*grid, next_col, next_row)) continue;
+
+      const std::size_t next = grid->cell(static_cast<std::uint32_t>(next_col), static_cast<std::uint32_t>(next_row));
+      if (grid->visited[next] || grid->kinds[next] != CELL_KIND::MAZE) continue;
+
+      grid->visited[next] = 1;
+      grid->wall_tile(col, row, CELL_STEPS[step][0], CELL_STEPS[step][1]) = '.';
+      grid->cell_tile(static_cast<std::uint32_t>(next_col), static_cast<std::uint32_t>(next_row)) = '.';
+      stack.push_back(static_cast<std::uint32_t>(next));
+      moved = true;
+      break;
+    }
+    if (!moved) stack.pop_back();
+  }
+}
+
+static std::uint32_t count_cell_exits(MazeGrid* grid, std::uint32_t col, std::uint32_t row) {
+  std::uint32_t exits = 0;
+  for (const auto& step : CELL_STEPS) {
+    if (!is_cell_in_grid(*grid, static_cast<int>(col) + step[0], static_cast<int>(row) + step[1])) continue;
+    exits += grid->wall_tile(col, row, step[0], step[1]) != '#';
+  }
+  return exits;
+}
+
+// Every dead end gets a second exit, preferably into another dead end
+static void braid_dead_ends(MazeGrid* grid, SimRandom* random) {
+  for (std::uint32_t row = 0; row < grid->cell_rows; ++row) {
+    for (std::uint32_t col = 0; col < grid->cell_cols; ++col) {
+      if (grid->kinds[grid->cell(col, row)] != CELL_KIND::MAZE) continue;
+      if (count_cell_exits(grid, col, row) != 1) continue;
+
+      int order[4] = { 0, 1, 2, 3 };
+      shuffle_steps(random, order);
+      int chosen = -1;
+      for (int step : order) {
+        const int dcol = CELL_STEPS[step][0];
+        const int drow = CELL_STEPS[step][1];
+        if (!can_join_cells(*grid, col, row, dcol, drow) || grid->wall_tile(col, row, dcol, drow) != '#') continue;
+        if (chosen < 0) chosen = step;
+        const std::uint32_t next_col = static_cast<std::uint32_t>(static_cast<int>(col) + dcol);
+        const std::uint32_t next_row = static_cast<std::uint32_t>(static_cast<int>(row) + drow);
+        if (count_cell_exits(grid, next_col, next_row) == 1) {
+          chosen = step;
+          break;
+        }
+      }
+      if (chosen >= 0) grid->wall_tile(col, row, CELL_STEPS[chosen][0], CELL_STEPS[chosen][1]) = '.';
+    }
+  }
+}
+
+static void add_loops(MazeGrid* grid, SimRandom* random, float corridor_density) {
+  if (corridor_density <= 0.0f) return;
+  const int threshold = static_cast<int>(std::min(corridor_density, 1.0f) * 10000.0f);
+
+  // Right and down walls only, each wall is looked at once
+  for (std::uint32_t row = 0; row < grid->cell_rows; ++row) {
+    for (std::uint32_t col = 0; col < grid->cell_cols; ++col) {
+      for (int step = 1; step < 4; step += 2) {
+        const int dcol = CELL_STEPS[step][0];
+        const int drow = CELL_STEPS[step][1];
+        if (!can_join_cells(*grid, col, row, dcol, drow)) continue;
+        char& wall = grid->wall_tile(col, row, dcol, drow);
+        if (wall == '#' && get_sim_random_value(random, 0, 9999) < threshold) wall = '.';
+      }
+    }
+  }
+}
+
+std::vector<std::string> generate_maze_lines(const MazeGenConfig& config) {
+  const std::uint16_t cols = config.cols;
+  const std::uint16_t rows = config.rows;
+  if (cols < MAZE_GEN_MIN_SIZE || rows < MAZE_GEN_MIN_SIZE || cols > MAX_LEVEL_SIZE || rows > MAX_LEVEL_SIZE) return {};
+  if (config.pen && (cols < MAZE_GEN_MIN_COLS_WITH_PEN || rows < MAZE_GEN_MIN_ROWS_WITH_PEN)) return {};
+
+  SimRandom random = {};
+  seed_sim_random(&random, config.seed);
+
+  MazeGrid grid = {};
+  grid.cell_cols = (cols - 1u) / 2u;
+  grid.cell_rows = (rows - 1u) / 2u;
+  grid.lines.assign(rows, std::string(cols, '#'));
+  grid.kinds.assign(std::size_t(grid.cell_cols) * grid.cell_rows, CELL_KIND::MAZE);
+  grid.visited.assign(grid.kinds.size(), 0);
+
+  // The ring takes 6x4 cells with the pen inside, at least a cell away
+  // from the border and with a row below it for the player
+  std::uint32_t ring_col = 0;
+  std::uint32_t ring_row = 0;
+  if (config.pen) {
+    const int max_ring_col = static_cast<int>(grid.cell_cols) - 7;
+    const int max_ring_row = static_cast<int>(grid.cell_rows) - 5;
+    ring_col = static_cast<std::uint32_t>(std::clamp(static_cast<int>(config.pen_x * grid.cell_cols - 3.0f + 0.5f), 1, max_ring_col));
+    ring_row = static_cast<std::uint32_t>(std::clamp(static_cast<int>(config.pen_y * grid.cell_rows - 2.0f + 0.5f), 1, max_ring_row));
+
+    for (std::uint32_t row = ring_row; row < ring_row + 4; ++row) {
+      for (std::uint32_t col = ring_col; col < ring_col + 6; ++col) {
+        const bool on_ring = row == ring_row || row == ring_row + 3 || col == ring_col || col == ring_col + 5;
+        grid.kinds[grid.cell(col, row)] = on_ring ? CELL_KIND::RING : CELL_KIND::PEN;
+      }
+    }
+  }
+
+  carve_corridors(&grid, &random, 0, 0);
+
+  // Tiles of the pen, pc/pr being its top left wall tile like in the
+  // classic maze: "###-####" over three rows of "#       #"
+  const std::uint32_t pc = 2 * ring_col + 2;
+  const std::uint32_t pr = 2 * ring_row + 2;
+  if (config.pen) {
+    for (std::uint32_t row = pr - 1; row <= pr + 5; ++row) {
+      for (std::uint32_t col = pc - 1; col <= pc + 9; ++col) {
+        const bool on_ring = row == pr - 1 || row == pr + 5 || col == pc - 1 || col == pc + 9;
+        const bool on_pen_wall = row == pr || row == pr + 4 || col == pc || col == pc + 8;
+        grid.tile(col, row) = on_ring ? ' ' : (on_pen_wall ? '#' : ' ');
+      }
+    }
+    grid.tile(pc + 4, pr) = '-';
+
+    // Ways into the ring from above and below the door
+    grid.tile(pc + 3, pr - 2) = '.';
+    grid.tile(pc + 5, pr + 6) = '.';
+  }
+
+  braid_dead_ends(&grid, &random);
+  add_loops(&grid, &random, config.corridor_density);
+
+  // Tunnels run from a cell row to both edges, away from the pen's rows
+  for (std::uint16_t tunnel = 0; tunnel < config.num_tunnels; ++tunnel) {
+    std::uint32_t cell_row = (tunnel + 1u) * grid.cell_rows / (config.num_tunnels + 1u);
+    if (config.pen && cell_row >= ring_row && cell_row < ring_row + 4) cell_row = ring_row + 4;
+    const std::uint32_t row = 2 * cell_row + 1;
+    if (row >= rows - 1u) continue;
+
+    std::string& line = grid.lines[row];
+    for (std::uint32_t col = 2 * grid.cell_cols; col < cols - 1u; ++col) line[col] = ' ';
+    line[0] = '=';
+    line[cols - 1u] = '=';
+  }
+
+  // Pills, the corners first
+  const std::uint32_t last_col = grid.cell_cols - 1;
+  const std::uint32_t last_row = grid.cell_rows - 1;
+  const std::uint32_t corners[4][2] = { { 0, 0 }, { last_col, 0 }, { 0, last_row }, { last_col, last_row } };
+  for (std::uint16_t pill = 0; pill < config.num_pills; ++pill) {
+    std::uint32_t col = 0;
+    std::uint32_t row = 0;
+    if (pill < 4) {
+      col = corners[pill][0];
+      row = corners[pill][1];
+    } else {
+      col = static_cast<std::uint32_t>(get_sim_random_value(&random, 0, static_cast<int>(last_col)));
+      row = static_cast<std::uint32_t>(get_sim_random_value(&random, 0, static_cast<int>(last_row)));
+    }
+    if (grid.kinds[grid.cell(col, row)] == CELL_KIND::MAZE) grid.cell_tile(col, row) = 'O';
+  }
+
+  // Spawns. With a pen the ghosts start in and above it, the player below
+  static const char GHOST_MARKERS[4] = { 'B', 'I', 'K', 'C' };
+  if (config.pen) {
+    grid.cell_tile(ring_col + 3, ring_row + 4) = 'P';
+    const std::uint16_t max_ghosts = MAZE_GEN_MAX_PEN_GHOSTS;
+    for (std::uint16_t ghost = 0; ghost < std::min(config.num_ghosts, max_ghosts); ++ghost) {
+      if (ghost == 0) {
+        grid.tile(pc + 4, pr - 1) = 'B';
+        continue;
+      }
+      // "#I K C #" like the arcade, then the rest of the pen
+      static const std::uint32_t FIRST_COLS[3] = { 2, 4, 6 };
+      const std::uint32_t slot = ghost - 1u;
+      const std::uint32_t col = (slot < 3) ? pc + FIRST_COLS[slot] : pc + 1 + (slot - 3) % 7;
+      const std::uint32_t row = (slot < 3) ? pr + 2 : (slot < 10) ? pr + 1 : pr + 3;
+      grid.tile(col, row) = GHOST_MARKERS[1 + slot % 3];
+    }
+  } else {
+    grid.cell_tile(grid.cell_cols / 2, grid.cell_rows * 3 / 4) = 'P';
+    // Anywhere in the top half, the next free cell if the random one is taken
+    const std::size_t top_cells = std::size_t(grid.cell_cols) * std::max(grid.cell_rows / 2, 1u);
+    for (std::uint16_t ghost = 0; ghost < std::min<std::uint16_t>(config.num_ghosts, MAX_ENTITIES - 1); ++ghost) {
+      std::size_t cell = static_cast<std::size_t>(get_sim_random_value(&random, 0, static_cast<int>(top_cells - 1)));
+      for (std::size_t tries = 0; tries < top_cells; ++tries, cell = (cell + 1) % top_cells) {
+        char& tile = grid.cell_tile(static_cast<std::uint32_t>(cell % grid.cell_cols),
+                                    static_cast<std::uint32_t>(cell / grid.cell_cols));
+        if (tile != '.') continue;
+        tile = GHOST_MARKERS[ghost % 4];
+        break;
+      }
+    }
+  }
+
+  return std::move(grid.lines);
+}
+
+GeneratedMaze generate_maze(const MazeGenConfig& config, std::uint16_t tile_size) {
+  GeneratedMaze maze = {};
+  const std::vector<std::string> lines = generate_maze_lines(config);
+  if (lines.empty()) return maze;
+
+  std::tie(maze.tile_map, maze.entities) = parse_level(lines, tile_size);
+  if (!find_level_pen(*maze.tile_map, &maze.pen_door, &maze.pen_home)) {
+    // No pen, dead ghosts head back to where Blinky started
+    const EntityId blinky = find_ghost(*maze.entities, GHOST_TYPE::BLINKY);
+    if (blinky != NO_ENTITY) maze.pen_door = maze.pen_home = maze.entities->tile_pos[blinky];
+  }
+  return maze;
+}
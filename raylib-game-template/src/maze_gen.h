@@ -0,0 +1,53 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "tile_map.h"
+#include "entity.h"
+#include "tile_pos.h"
+
+// Procedural mazes of any size for scaling and stress tests. The same seed
+// and config always give the same maze.
+//
+// Corridors are carved on a lattice of cells (odd rows/columns), starting
+// with a randomized depth first search, which gives long winding corridors.
+// Dead ends are then joined to a neighbour, like in the arcade's maze, and
+// corridor_density knocks out that fraction of the remaining walls between
+// corridors for loops and open areas. The ghost pen sits on a ring corridor
+// like the classic one, with Blinky above the door and the player below.
+struct MazeGenConfig {
+  std::uint16_t cols{28};
+  std::uint16_t rows{31};
+  std::uint64_t seed{1};
+  float corridor_density{0.1f};      // 0 braided corridors only, 1 every wall between cells gone
+  bool pen{true};
+  float pen_x{0.5f};                 // pen center, as a fraction of the maze size
+  float pen_y{0.4f};
+  std::uint16_t num_tunnels{1};      // teleport rows, spread evenly
+  std::uint16_t num_pills{4};        // the first four go in the corners
+  std::uint16_t num_ghosts{4};       // types cycle after Clyde
+};
+
+// Minimal sizes a maze can be generated at
+constexpr std::uint16_t MAZE_GEN_MIN_SIZE = 5;
+constexpr std::uint16_t MAZE_GEN_MIN_COLS_WITH_PEN = 17;
+constexpr std::uint16_t MAZE_GEN_MIN_ROWS_WITH_PEN = 13;
+// Blinky above the door and the pen's 17 free tiles
+constexpr std::uint16_t MAZE_GEN_MAX_PEN_GHOSTS = 18;
+
+struct GeneratedMaze {
+  std::unique_ptr<TileMap> tile_map;         // null if the config can't be generated
+  std::unique_ptr<EntityStore> entities;
+  TilePos pen_door{};                        // see find_level_pen()
+  TilePos pen_home{};
+
+  bool ok() const { return tile_map != nullptr; }
+};
+
+// The maze in parse_level()'s characters, one string per row. Empty if the
+// size is out of range or too small for the pen.
+std::vector<std::string> generate_maze_lines(const MazeGenConfig& config);
+
+// Parsed like any other level
+GeneratedMaze generate_maze(const MazeGenConfig& config, std::uint16_t tile_size);
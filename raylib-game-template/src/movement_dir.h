@@ -1,6 +1,6 @@
 #pragma once
 #include <cstdint>
-#include "raylib.h"
+#include "tile_pos.h"
 
 enum class MOVEMENT_DIR : std::uint8_t {
   STOPPED = 0,
@@ -41,12 +41,30 @@ inline float get_dir_scale_y_sign(MOVEMENT_DIR dir) {
 }
 
 // Get the positional delta in a given direction
-inline Vector2 get_step_delta(MOVEMENT_DIR dir) {
+inline TilePos get_step_delta(MOVEMENT_DIR dir) {
   switch (dir) {
-  case MOVEMENT_DIR::UP:    return { 0.0f, -1.0f };
-  case MOVEMENT_DIR::DOWN:  return { 0.0f,  1.0f };
-  case MOVEMENT_DIR::LEFT:  return {-1.0f,  0.0f };
-  case MOVEMENT_DIR::RIGHT: return { 1.0f,  0.0f };
-  default:                  return { 0.0f,  0.0f };
+  case MOVEMENT_DIR::UP:    return { 0, -1 };
+  case MOVEMENT_DIR::DOWN:  return { 0,  1 };
+  case MOVEMENT_DIR::LEFT:  return {-1,  0 };
+  case MOVEMENT_DIR::RIGHT: return { 1,  0 };
+  default:                  return { 0,  0 };
+  }
+}
+
+// Bit for a direction in per-tile neighbour masks (see tile_exit_masks.h)
+inline std::uint8_t get_dir_bit(MOVEMENT_DIR dir) {
+  return (dir == MOVEMENT_DIR::STOPPED)
+    ? std::uint8_t(0)
+    : static_cast<std::uint8_t>(1u << (static_cast<std::uint8_t>(dir) - 1u));
+}
+
+// Direction of a mask with a single bit set, STOPPED otherwise
+inline MOVEMENT_DIR get_single_dir(std::uint8_t mask) {
+  switch (mask) {
+  case 1:  return MOVEMENT_DIR::UP;
+  case 2:  return MOVEMENT_DIR::DOWN;
+  case 4:  return MOVEMENT_DIR::RIGHT;
+  case 8:  return MOVEMENT_DIR::LEFT;
+  default: return MOVEMENT_DIR::STOPPED;
   }
 }
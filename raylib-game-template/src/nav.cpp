@@ -0,0 +1,187 @@
+#include "nav.h"
+#include <vector>
+
+// Ghosts can use doors, so only walls block the BFS
+static bool is_nav_walkable(TILE_TYPE tile) {
+  return tile != TILE_TYPE::WALL;
+}
+
+// Where an entity ends up when standing on a teleport tile,
+// mirrors handle_entity_on_teleport_tile()
+static bool get_teleport_dest(const TileMap& tile_map, std::uint16_t col,
+                              std::uint16_t* dest_col) {
+  if (col == 0) {
+    *dest_col = static_cast<std::uint16_t>(tile_map.cols - 2);
+    return true;
+  }
+  if (col == tile_map.cols - 1) {
+    *dest_col = 1;
+    return true;
+  }
+  return false;
+}
+
+static bool is_distance_cache_valid(const DistanceFieldCache& cache, const TileMap& tile_map) {
+  return cache.layout == tile_map.layout_storage() && cache.walkable_index &&
+         cache.layout_version == tile_map.layout_version;
+}
+
+void sync_distance_fields(DistanceFieldCache* cache, const TileMap& tile_map) {
+  if (is_distance_cache_valid(*cache, tile_map)) return;
+
+  const std::size_t total_tiles = std::size_t(tile_map.rows) * tile_map.cols;
+  cache->layout = tile_map.layout_storage();
+  cache->layout_version = tile_map.layout_version;
+  cache->walkable_index = std::make_unique<std::uint32_t[]>(total_tiles);
+
+  std::uint32_t num_walkable = 0;
+  for (std::uint16_t row = 0; row < tile_map.rows; ++row) {
+    for (std::uint16_t col = 0; col < tile_map.cols; ++col) {
+      cache->walkable_index[tile_map.index(col, row)] = is_nav_walkable(tile_map.get(col, row))
+        ? num_walkable++ : DistanceFieldCache::NOT_WALKABLE;
+    }
+  }
+
+  cache->num_walkable = num_walkable;
+  cache->walkable_tiles = std::make_unique<std::uint32_t[]>(num_walkable);
+  for (std::size_t i = 0; i < total_tiles; ++i) {
+    const std::uint32_t idx = cache->walkable_index[i];
+    if (idx != DistanceFieldCache::NOT_WALKABLE) {
+      cache->walkable_tiles[idx] = static_cast<std::uint32_t>(i);
+    }
+  }
+
+  // Old fields are meaningless for the new layout
+  cache->fields = std::make_unique<std::unique_ptr<std::uint16_t[]>[]>(num_walkable);
+  cache->last_used = std::make_unique<std::uint64_t[]>(num_walkable);
+  cache->built.clear();
+  cache->num_lookups = 0;
+  cache->complete = false;
+}
+
+std::uint32_t get_max_distance_fields(const DistanceFieldCache& cache) {
+  const std::size_t field_bytes = std::size_t(cache.num_walkable) * sizeof(std::uint16_t);
+  if (field_bytes == 0) return cache.num_walkable;
+  const std::size_t max_fields = cache.max_bytes / field_bytes;
+  if (max_fields == 0) return 1;
+  return max_fields < cache.num_walkable ? static_cast<std::uint32_t>(max_fields) : cache.num_walkable;
+}
+
+// Hands out the least recently used field once the cache is full, so
+// building a field past the limit doesn't allocate
+static std::unique_ptr<std::uint16_t[]> take_field_storage(DistanceFieldCache* cache) {
+  if (cache->built.size() < get_max_distance_fields(*cache)) {
+    return std::make_unique<std::uint16_t[]>(cache->num_walkable);
+  }
+
+  std::size_t oldest = 0;
+  for (std::size_t i = 1; i < cache->built.size(); ++i) {
+    if (cache->last_used[cache->built[i]] < cache->last_used[cache->built[oldest]]) oldest = i;
+  }
+  std::unique_ptr<std::uint16_t[]> field = std::move(cache->fields[cache->built[oldest]]);
+  cache->built[oldest] = cache->built.back();
+  cache->built.pop_back();
+  return field;
+}
+
+static void build_distance_field(DistanceFieldCache* cache, const TileMap& tile_map,
+                                 std::uint32_t target) {
+  std::unique_ptr<std::uint16_t[]> field = take_field_storage(cache);
+  for (std::uint32_t i = 0; i < cache->num_walkable; ++i) {
+    field[i] = DistanceFieldCache::UNREACHABLE;
+  }
+
+  // BFS from the target, so every step is walked backwards: a tile gets
+  // dist + 1 when it can step into a tile at dist. Teleport tiles are the
+  // one asymmetric case, an entity on one is moved to its destination
+  // before it moves again, so it's exactly as far as its destination.
+  std::vector<std::uint32_t> queue;
+  queue.reserve(cache->num_walkable);
+  queue.push_back(target);
+  field[target] = 0;
+
+  const int offsets[4][2] = { {0, -1}, {-1, 0}, {0, 1}, {1, 0} };
+
+  auto expand = [&](std::uint16_t col, std::uint16_t row, std::uint16_t dist) {
+    for (const auto& offset : offsets) {
+      const int c = col + offset[0];
+      const int r = row + offset[1];
+      if (c < 0 || r < 0) continue;
+      const std::uint16_t ucol = static_cast<std::uint16_t>(c);
+      const std::uint16_t urow = static_cast<std::uint16_t>(r);
+      if (!tile_map.in_bounds(ucol, urow)) continue;
+      if (tile_map.get(ucol, urow) == TILE_TYPE::TELEPORT) continue;
+
+      const std::uint32_t idx = cache->walkable_index[tile_map.index(ucol, urow)];
+      if (idx == DistanceFieldCache::NOT_WALKABLE) continue;
+      if (field[idx] != DistanceFieldCache::UNREACHABLE) continue;
+
+      field[idx] = static_cast<std::uint16_t>(dist + 1);
+      queue.push_back(idx);
+    }
+  };
+
+  for (std::size_t head = 0; head < queue.size(); ++head) {
+    const std::uint32_t current = queue[head];
+    // Tiles past the cap are left UNREACHABLE
+    const std::uint16_t dist = field[current];
+    if (dist >= DistanceFieldCache::MAX_DISTANCE) continue;
+
+    const std::uint32_t tile_idx = cache->walkable_tiles[current];
+    const std::uint16_t col = static_cast<std::uint16_t>(tile_idx % tile_map.cols);
+    const std::uint16_t row = static_cast<std::uint16_t>(tile_idx / tile_map.cols);
+
+    expand(col, row, dist);
+
+    for (std::uint16_t teleport_col : { std::uint16_t(0), std::uint16_t(tile_map.cols - 1) }) {
+      std::uint16_t dest_col = 0;
+      if (tile_map.get(teleport_col, row) != TILE_TYPE::TELEPORT) continue;
+      if (!get_teleport_dest(tile_map, teleport_col, &dest_col) || dest_col != col) continue;
+
+      const std::uint32_t teleport = cache->walkable_index[tile_map.index(teleport_col, row)];
+      if (field[teleport] != DistanceFieldCache::UNREACHABLE) continue;
+      field[teleport] = dist;
+      expand(teleport_col, row, dist);
+    }
+  }
+
+  cache->fields[target] = std::move(field);
+  cache->built.push_back(target);
+}
+
+bool build_all_distance_fields(DistanceFieldCache* cache, const TileMap& tile_map) {
+  sync_distance_fields(cache, tile_map);
+  if (get_max_distance_fields(*cache) < cache->num_walkable) return false;
+
+  for (std::uint32_t target = 0; target < cache->num_walkable; ++target) {
+    if (!cache->fields[target]) build_distance_field(cache, tile_map, target);
+  }
+  cache->complete = true;
+  return true;
+}
+
+const std::uint16_t* find_distance_field(const DistanceFieldCache& cache, const TileMap& tile_map,
+                                         std::uint16_t target_col, std::uint16_t target_row) {
+  if (!is_distance_cache_valid(cache, tile_map) || !tile_map.in_bounds(target_col, target_row)) return nullptr;
+
+  const std::uint32_t target = cache.walkable_index[tile_map.index(target_col, target_row)];
+  if (target == DistanceFieldCache::NOT_WALKABLE) return nullptr;
+  return cache.fields[target].get();
+}
+
+const std::uint16_t* get_distance_field(DistanceFieldCache* cache, const TileMap& tile_map,
+                                        std::uint16_t target_col, std::uint16_t target_row) {
+  if (cache->shared) return find_distance_field(*cache->shared, tile_map, target_col, target_row);
+
+  sync_distance_fields(cache, tile_map);
+  if (!tile_map.in_bounds(target_col, target_row)) return nullptr;
+
+  const std::uint32_t target = cache->walkable_index[tile_map.index(target_col, target_row)];
+  if (target == DistanceFieldCache::NOT_WALKABLE) return nullptr;
+
+  if (cache->complete) return cache->fields[target].get();
+
+  if (!cache->fields[target]) build_distance_field(cache, tile_map, target);
+  cache->last_used[target] = ++cache->num_lookups;
+  return cache->fields[target].get();
+}
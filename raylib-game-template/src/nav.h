@@ -0,0 +1,76 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <vector>
+#include "tile_map.h"
+
+// Shortest path (BFS) distances between the walkable tiles of a TileMap.
+// Ghosts use it for "true shortest path" targeting instead of the arcade's
+// straight-line distance. One field per target tile holds the distance from
+// every walkable tile to that target, fields are built on first use and
+// kept until the map layout (walls/doors/teleports) changes.
+//
+// Distances are 16-bit and capped at MAX_DISTANCE: tiles further than that
+// from the target read as UNREACHABLE, so ghosts that far away fall back to
+// the straight line. Only mazes with paths longer than 65534 tiles hit the
+// cap, their all-pairs fields wouldn't fit in memory anyway.
+//
+// At most max_bytes of fields are kept, building one more drops the least
+// recently used. FRIGHTENED ghosts target random tiles, so a long game
+// would otherwise end up with a field for most of the maze.
+//
+// NOTE: lazily building fields mutates the cache, even a lookup updates the
+// eviction order. Threads can share a cache completed by
+// build_all_distance_fields() by pointing their own caches' shared at it.
+struct DistanceFieldCache {
+  static constexpr std::uint16_t UNREACHABLE = 0xffff;
+  static constexpr std::uint16_t MAX_DISTANCE = UNREACHABLE - 1;
+  static constexpr std::uint32_t NOT_WALKABLE = 0xffffffff;
+  static constexpr std::size_t DEFAULT_MAX_BYTES = std::size_t(256) << 20;
+
+  const std::uint64_t* layout{nullptr};             // see TileMap::layout_storage()
+  std::uint32_t layout_version{0};
+  std::uint32_t num_walkable{0};
+  std::size_t max_bytes{DEFAULT_MAX_BYTES};         // fields kept at once, at least one is
+  std::unique_ptr<std::uint32_t[]> walkable_index;   // tile index -> compact walkable index
+  std::unique_ptr<std::uint32_t[]> walkable_tiles;   // compact walkable index -> tile index
+  std::unique_ptr<std::unique_ptr<std::uint16_t[]>[]> fields; // per target, indexed by source
+  std::unique_ptr<std::uint64_t[]> last_used;       // per target, num_lookups at its last lookup
+  std::vector<std::uint32_t> built;                 // targets that have a field
+  std::uint64_t num_lookups{0};
+  bool complete{false};                             // every target has a field
+  const DistanceFieldCache* shared{nullptr};        // complete, looked up instead of this one
+};
+
+// (Re)builds the walkable tile index if the cache was made for another map or
+// an older layout. Cheap when nothing changed.
+void sync_distance_fields(DistanceFieldCache* cache, const TileMap& tile_map);
+
+// How many fields fit in cache.max_bytes, at least one
+std::uint32_t get_max_distance_fields(const DistanceFieldCache& cache);
+
+// Eagerly builds the fields for every walkable target tile. Returns false,
+// building nothing, if they don't all fit in max_bytes.
+bool build_all_distance_fields(DistanceFieldCache* cache, const TileMap& tile_map);
+
+// Field towards the given target if the cache, valid for tile_map, already
+// has it. Never writes, so any number of threads can use a complete cache.
+const std::uint16_t* find_distance_field(const DistanceFieldCache& cache, const TileMap& tile_map,
+                                         std::uint16_t target_col, std::uint16_t target_row);
+
+// Distance field towards the given target tile, indexed by the compact
+// walkable index of the source tile. nullptr if the target isn't walkable.
+// The field can be evicted by the next call, don't hold on to it.
+const std::uint16_t* get_distance_field(DistanceFieldCache* cache, const TileMap& tile_map,
+                                        std::uint16_t target_col, std::uint16_t target_row);
+
+inline std::uint16_t get_field_distance(const DistanceFieldCache& cache,
+                                        const std::uint16_t* field,
+                                        const TileMap& tile_map,
+                                        std::uint16_t col, std::uint16_t row) {
+  if (!tile_map.in_bounds(col, row)) return DistanceFieldCache::UNREACHABLE;
+  const DistanceFieldCache& index_cache = cache.shared ? *cache.shared : cache;
+  const std::uint32_t idx = index_cache.walkable_index[tile_map.index(col, row)];
+  return (idx == DistanceFieldCache::NOT_WALKABLE) ? DistanceFieldCache::UNREACHABLE : field[idx];
+}
@@ -4,90 +4,90 @@
 #include "entity.h"
 #include "timer.h"
 #include "movement_dir.h"
-#include "raymath.h"
+#include "tile_exit_masks.h"
 
-void update_player(TileMap* tile_map, Entity* player, float dt) {
-  float& player_x = player->tile_pos.x;
-  float& player_y = player->tile_pos.y;
+// Neighbours the player can step into. Walls and doors block in any
+// direction (player cannot enter monster pen)
+static std::uint8_t get_passable_mask(const TileMap& tile_map, const TileExitMasks* exit_masks,
+                                      TilePos player_pos) {
+  if (are_exit_masks_valid(exit_masks, tile_map) && tile_map.in_bounds(player_pos)) {
+    const std::size_t idx = tile_map.index(player_pos);
+    return exit_masks->exit_mask[idx] & ~exit_masks->door_mask[idx];
+  }
+
+  auto is_passable_for_player = [](TILE_TYPE tile) -> bool {
+    if (tile == TILE_TYPE::WALL) return false;
+    if (tile == TILE_TYPE::DOOR) return false;
+    return true;
+  };
+
+  std::uint8_t mask = 0;
+  for (MOVEMENT_DIR dir : { MOVEMENT_DIR::LEFT, MOVEMENT_DIR::RIGHT, MOVEMENT_DIR::UP, MOVEMENT_DIR::DOWN }) {
+    if (is_passable_for_player(tile_map.get(player_pos + get_step_delta(dir)))) mask |= get_dir_bit(dir);
+  }
+  return mask;
+}
+
+TILE_TYPE update_player(TileMap* tile_map, EntityStore* entities, const TileExitMasks* exit_masks, float dt) {
+  TilePos& tile_pos = entities->tile_pos[PLAYER_ID];
+  MOVEMENT_DIR& dir = entities->dir[PLAYER_ID];
+  MOVEMENT_DIR& next_dir = entities->next_dir[PLAYER_ID];
 
-  TILE_TYPE current_tile = tile_map->get(player_x, player_y);
+  TILE_TYPE current_tile = tile_map->get(tile_pos);
 
   // Collect any dots we land on
   if (current_tile == TILE_TYPE::DOT) {
-    tile_map->set(player_x, player_y, TILE_TYPE::EMPTY);
-    player->collected_dots += 1;
+    tile_map->set(tile_pos, TILE_TYPE::EMPTY);
+    entities->collected_dots += 1;
   }
 
   // Energize the player if he lands on a pill
   if (current_tile == TILE_TYPE::PILL) {
-    tile_map->set(player_x, player_y, TILE_TYPE::EMPTY);
-    player->is_energized = true;
-    player->energized_timer.set_duration(6.0);
-    player->energized_timer.start();
+    tile_map->set(tile_pos, TILE_TYPE::EMPTY);
+    entities->is_energized = true;
+    entities->energized_timer.set_duration(6.0);
+    entities->energized_timer.start();
   }
 
-  if (player->energized_timer.running()) {
-    player->energized_timer.update(static_cast<double>(dt));
+  if (entities->energized_timer.running()) {
+    entities->energized_timer.update(static_cast<double>(dt));
   } else {
-    player->is_energized = false;
+    entities->is_energized = false;
   }
 
   if (current_tile == TILE_TYPE::TELEPORT) {
-    handle_entity_on_teleport_tile(player, tile_map->cols);
+    handle_entity_on_teleport_tile(entities, PLAYER_ID, tile_map->cols);
   }
 
-  TILE_TYPE left_tile = tile_map->get(player_x - 1.0f, player_y);
-  TILE_TYPE right_tile = tile_map->get(player_x + 1.0f, player_y);
-  TILE_TYPE up_tile = tile_map->get(player_x, player_y - 1.0f);
-  TILE_TYPE down_tile = tile_map->get(player_x, player_y + 1.0f);
-
-  auto tile_ahead_of = [&](MOVEMENT_DIR dir) -> TILE_TYPE {
-    switch (dir) {
-    case MOVEMENT_DIR::LEFT:  return left_tile;
-    case MOVEMENT_DIR::RIGHT: return right_tile;
-    case MOVEMENT_DIR::UP:    return up_tile;
-    case MOVEMENT_DIR::DOWN:  return down_tile;
-    default:                  return current_tile;
-    }
-  };
-  
-  // Player passability: walls and doors block in any direction (player cannot enter monster pen)
-  auto is_passable_for_player = [&](TILE_TYPE tile) -> bool {
-    if (tile == TILE_TYPE::WALL) return false;
-    if (tile == TILE_TYPE::DOOR) return false;
-    return true;
-  };
+  const std::uint8_t passable_mask = get_passable_mask(*tile_map, exit_masks, tile_pos);
 
   // Stop if the tile ahead isn’t passable
-  if (player->dir != MOVEMENT_DIR::STOPPED) {
-    TILE_TYPE tile_ahead = tile_ahead_of(player->dir);
-    if (!is_passable_for_player(tile_ahead)) {
-      player->dir = MOVEMENT_DIR::STOPPED;
+  if (dir != MOVEMENT_DIR::STOPPED) {
+    if (!(passable_mask & get_dir_bit(dir))) {
+      dir = MOVEMENT_DIR::STOPPED;
     }
   }
 
   // Start queued turn if destination is passable
-  if (player->next_dir != MOVEMENT_DIR::STOPPED) {
-    const TILE_TYPE tile_next = tile_ahead_of(player->next_dir);
-    if (is_passable_for_player(tile_next)) {
-      player->dir = player->next_dir;
-      player->next_dir = MOVEMENT_DIR::STOPPED;
+  if (next_dir != MOVEMENT_DIR::STOPPED) {
+    if (passable_mask & get_dir_bit(next_dir)) {
+      dir = next_dir;
+      next_dir = MOVEMENT_DIR::STOPPED;
     }
   }
 
   // Advance player position to next tile
-  player->move_timer += dt;
-  while (player->move_timer >= player->tile_step_time) {
-    player->move_timer -= player->tile_step_time;
+  float& move_timer = entities->move_timer[PLAYER_ID];
+  const float tile_step_time = entities->tile_step_time[PLAYER_ID];
+  move_timer += dt;
+  while (move_timer >= tile_step_time) {
+    move_timer -= tile_step_time;
 
     // record previous position BEFORE stepping
-    player->prev_tile_pos = player->tile_pos;
-
-    const Vector2 step_delta = get_step_delta(player->dir);
-    player->tile_pos.x += step_delta.x;
-    player->tile_pos.y += step_delta.y;
-
-    player->rotation = get_dir_rotation(player->dir);
-    player->scale.y = get_dir_scale_y_sign(player->dir) * std::fabsf(player->scale.y);
+    entities->prev_tile_pos[PLAYER_ID] = tile_pos;
+    tile_pos = tile_pos + get_step_delta(dir);
   }
+
+  return (current_tile == TILE_TYPE::DOT || current_tile == TILE_TYPE::PILL)
+    ? current_tile : TILE_TYPE::EMPTY;
 }
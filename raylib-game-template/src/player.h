@@ -1,6 +1,10 @@
 #pragma once
+#include "tile_map.h"
 
-struct TileMap;
-struct Entity;
+struct EntityStore;
+struct TileExitMasks;
 
-void update_player(TileMap* tile_map, Entity* player, float dt);
+// Moves the player entity (PLAYER_ID), collecting dots and pills on the way.
+// Returns what was collected this step (DOT/PILL), EMPTY otherwise.
+// exit_masks is optional, when valid it replaces the neighbour tile probes
+TILE_TYPE update_player(TileMap* tile_map, EntityStore* entities, const TileExitMasks* exit_masks, float dt);
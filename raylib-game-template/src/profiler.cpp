@@ -0,0 +1,37 @@
+#include "profiler.h"
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+
+std::uint32_t read_profile_samples(const FrameProfiler& profiler, ProfileSample* out,
+                                   std::uint32_t max_samples) {
+  const std::uint64_t end = profiler.write_index.load(std::memory_order_acquire);
+  // Stay clear of the slots the writer is about to reuse
+  const std::uint64_t available = std::min<std::uint64_t>(end, PROFILER_CAPACITY / 2);
+  const std::uint32_t count = static_cast<std::uint32_t>(std::min<std::uint64_t>(available, max_samples));
+
+  for (std::uint64_t i = 0; i < count; ++i) {
+    out[i] = profiler.samples[(end - count + i) & (PROFILER_CAPACITY - 1)];
+  }
+  return count;
+}
+
+bool export_chrome_trace(const FrameProfiler& profiler, const char* path) {
+  auto samples = std::make_unique<ProfileSample[]>(PROFILER_CAPACITY);
+  const std::uint32_t count = read_profile_samples(profiler, samples.get(), PROFILER_CAPACITY);
+
+  std::FILE* file = std::fopen(path, "w");
+  if (!file) return false;
+
+  // Complete ("X") events, times in microseconds
+  std::fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+  for (std::uint32_t i = 0; i < count; ++i) {
+    const ProfileSample& sample = samples[i];
+    std::fprintf(file, "{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%.3f,\"dur\":%.3f,"
+                 "\"args\":{\"id\":%u}}%s\n",
+                 sample.name, sample.start_ns / 1000.0, sample.duration_ns / 1000.0,
+                 sample.id, (i + 1 < count) ? "," : "");
+  }
+  std::fprintf(file, "]}\n");
+  return std::fclose(file) == 0;
+}
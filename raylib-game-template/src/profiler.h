@@ -0,0 +1,75 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <chrono>
+
+// Low overhead scoped timing of the game loop's phases. Samples go into a
+// fixed size ring buffer: the thread being profiled is the only writer and
+// publishes each sample with an atomic store, readers (the overlay, trace
+// export) only ever look at published samples, nothing is locked or
+// allocated.
+//
+// Instrumented code takes an optional FrameProfiler*, with nullptr a scope
+// costs a single branch. Nothing in the simulation depends on it.
+
+constexpr std::uint32_t PROFILER_CAPACITY = 1u << 16;   // power of two
+
+struct ProfileSample {
+  const char* name;                 // string literal, never copied
+  std::uint64_t start_ns;           // since the profiler was created
+  std::uint32_t duration_ns;
+  std::uint16_t depth;              // nesting level, 0 for the frame itself
+  std::uint16_t id;                 // e.g. the ghost's EntityId, 0 if unused
+};
+
+struct FrameProfiler {
+  std::chrono::steady_clock::time_point epoch{std::chrono::steady_clock::now()};
+  std::atomic<std::uint64_t> write_index{0};       // samples written so far
+  std::uint16_t depth{0};                          // writer only
+  bool show_overlay{false};
+  ProfileSample samples[PROFILER_CAPACITY];
+
+  std::uint64_t now_ns() const {
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now() - epoch).count());
+  }
+};
+
+// Times the enclosing scope
+struct ProfileScope {
+  FrameProfiler* profiler;
+  const char* name;
+  std::uint16_t id;
+  std::uint64_t start_ns{0};
+
+  ProfileScope(FrameProfiler* profiler, const char* name, std::uint16_t id = 0)
+    : profiler(profiler), name(name), id(id) {
+    if (!profiler) return;
+    start_ns = profiler->now_ns();
+    ++profiler->depth;
+  }
+
+  ~ProfileScope() {
+    if (!profiler) return;
+    const std::uint64_t end_ns = profiler->now_ns();
+    const std::uint16_t depth = --profiler->depth;
+    const std::uint64_t idx = profiler->write_index.load(std::memory_order_relaxed);
+    profiler->samples[idx & (PROFILER_CAPACITY - 1)] = ProfileSample{
+      name, start_ns, static_cast<std::uint32_t>(end_ns - start_ns), depth, id
+    };
+    profiler->write_index.store(idx + 1, std::memory_order_release);
+  }
+
+  ProfileScope(const ProfileScope&) = delete;
+  ProfileScope& operator=(const ProfileScope&) = delete;
+};
+
+// Copies up to max_samples of the most recent samples into out, oldest
+// first, and returns how many. Samples are written when their scope ends,
+// so nested scopes come before the scope around them.
+std::uint32_t read_profile_samples(const FrameProfiler& profiler, ProfileSample* out,
+                                   std::uint32_t max_samples);
+
+// Writes everything still in the ring buffer as Chrome trace_event JSON
+// (load it in chrome://tracing or ui.perfetto.dev). Returns false on I/O errors.
+bool export_chrome_trace(const FrameProfiler& profiler, const char* path);
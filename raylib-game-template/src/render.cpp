@@ -0,0 +1,562 @@
+#include "render.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include "raymath.h"
+#include "rlgl.h"
+
+void load_entity_texture(EntityRender* render, Texture2D texture, Rectangle sheet) {
+  render->texture = texture;
+  render->sheet = sheet;
+
+  // setup animation context
+  render->anim_ctx.frame_rec = {
+    sheet.x,
+    sheet.y,
+    static_cast<float>(static_cast<int>(sheet.width) / 8),
+    sheet.height
+  };
+  render->anim_ctx.current_frame = 0;
+  render->anim_ctx.frames_speed = 8; // 8 fps or 8 frames per sheet
+}
+
+void load_entities_textures(EntityRenderStore* render_store, const EntityStore& entities) {
+  // Indexed by ENTITY_SPRITE
+  static const char* const SPRITE_PATHS[] = {
+    "resources/pacman_texture.png",
+    "resources/blinky_spritesheet.png",
+    "resources/pinky_spritesheet.png",
+    "resources/inky_spritesheet.png",
+    "resources/clyde_spritesheet.png"
+  };
+  static_assert(sizeof(SPRITE_PATHS) / sizeof(SPRITE_PATHS[0]) == static_cast<std::size_t>(ENTITY_SPRITE::COUNT),
+                "a path per ENTITY_SPRITE");
+
+  SpriteAtlas& atlas = render_store->atlas;
+  // Failed images were logged by load_sprite_atlas, their entities draw nothing
+  if (!load_sprite_atlas(&atlas, SPRITE_PATHS, static_cast<std::size_t>(ENTITY_SPRITE::COUNT))) {
+    TraceLog(LOG_WARNING, "Could not build the entity sprite atlas, entities won't be drawn");
+  }
+  if (atlas.rects.empty()) atlas.rects.assign(static_cast<std::size_t>(ENTITY_SPRITE::COUNT), Rectangle{});
+
+  load_entity_texture(&render_store->components[PLAYER_ID], atlas.texture,
+                      atlas.rects[static_cast<std::size_t>(ENTITY_SPRITE::PACMAN)]);
+  for (EntityId id = PLAYER_ID + 1; id < entities.count; ++id) {
+    // GHOST_TYPE and ENTITY_SPRITE list the ghosts in the same order
+    const std::uint8_t type = static_cast<std::uint8_t>(entities.ghost_type[id]);
+    const std::size_t sprite = (type > 0 && type <= 4) ? type : static_cast<std::size_t>(ENTITY_SPRITE::BLINKY);
+    load_entity_texture(&render_store->components[id], atlas.texture, atlas.rects[sprite]);
+  }
+}
+
+void unload_entities_textures(EntityRenderStore* render_store) {
+  unload_sprite_atlas(&render_store->atlas);
+}
+
+Vector2 get_entity_draw_pos(const TileMap& tile_map, const EntityStore& entities, EntityId id,
+                            float sim_remainder) {
+  const float tile_size = static_cast<float>(tile_map.tile_size);
+  const TilePos prev_tile_pos = entities.prev_tile_pos[id];
+  const TilePos tile_pos = entities.tile_pos[id];
+
+  float alpha = Clamp((entities.move_timer[id] + sim_remainder) / entities.tile_step_time[id],
+                      0.0f, 1.0f);
+  Vector2 interp_tile = {
+    Lerp(static_cast<float>(prev_tile_pos.col), static_cast<float>(tile_pos.col), alpha),
+    Lerp(static_cast<float>(prev_tile_pos.row), static_cast<float>(tile_pos.row), alpha)
+  };
+
+  // Calculate the new interpolated position and center it
+  return Vector2{
+    interp_tile.x * tile_size + (tile_size / 2),
+    interp_tile.y * tile_size + (tile_size / 2)
+  };
+}
+
+void render_entity(const TileMap& tile_map, const EntityStore& entities, EntityId id,
+                   EntityRender* render, Color tint, float dt, float sim_remainder) {
+  const Texture2D texture = render->texture;
+  const Rectangle sheet = render->sheet;
+  const Vector2 entity_pos = get_entity_draw_pos(tile_map, entities, id, sim_remainder);
+
+  EntityAnimationContext& anim_ctx = render->anim_ctx;
+  const float frame_duration = 1.0f / static_cast<float>(anim_ctx.frames_speed);
+
+  // Accumulate elapsed time
+  anim_ctx.time_accum += dt;
+
+  while (anim_ctx.time_accum >= frame_duration) {
+    anim_ctx.time_accum -= frame_duration;
+
+    // Advance to next frame
+    ++anim_ctx.current_frame;
+    if (anim_ctx.current_frame > 5) {
+      anim_ctx.current_frame = 0;
+    }
+
+    anim_ctx.frame_rec.x = sheet.x + static_cast<float>(anim_ctx.current_frame) *
+      static_cast<float>(static_cast<int>(sheet.width) / 8);
+  }
+
+  Rectangle src = anim_ctx.frame_rec;
+  const float frame_w = std::fabsf(src.width);
+  const float frame_h = src.height;
+
+  // NOTE: corner case, mirror flip (right -> left) the source rect if scale.x is negative
+  if (render->scale.y < 0.0f) {
+    src.x += frame_w;   // shift to the right edge of the frame
+    src.width = -frame_w;
+  } else {
+    src.width = frame_w;
+  }
+
+  const float draw_w = frame_w * std::fabsf(render->scale.x);
+  const float draw_h = frame_h * std::fabsf(render->scale.y);
+ 
+  Rectangle dst = {
+    entity_pos.x,  // tile center X
+    entity_pos.y,  // tile center Y
+    draw_w,
+    draw_h
+  };
+
+  // Origin inside destination rect (0,0 = top-left; to center use half size)
+  Vector2 origin = { draw_w * 0.5f, draw_h * 0.5f  };
+
+  DrawTexturePro(texture, src, dst, origin, render->rotation, tint);
+}
+
+static void draw_walls(const TileMap& tile_map) {
+  const std::uint16_t tile_size = tile_map.tile_size;
+
+  // Walk the set bits of the wall bitboard only, empty tiles don't cost anything
+  for (std::uint16_t row = 0; row < tile_map.rows; ++row) {
+    const int pixel_y = row * tile_size;
+    const std::uint64_t* walls = tile_map.layer_row(TILE_TYPE::WALL, row);
+
+    for (std::uint16_t word = 0; word < tile_map.words_per_row; ++word) {
+      const int word_pixel_x = word * 64 * tile_size;
+      for (std::uint64_t bits = walls[word]; bits; bits &= bits - 1) {
+        const int pixel_x = word_pixel_x + static_cast<int>(ctz64(bits)) * tile_size;
+        DrawRectangle(pixel_x, pixel_y, tile_size, tile_size, GREEN);
+      }
+    }
+  }
+}
+
+// The rectangles of a chunk of the wall mesh
+static void draw_wall_chunk(const WallMesh& wall_mesh, std::size_t chunk, std::uint16_t tile_size) {
+  for (std::uint32_t i = wall_mesh.chunk_first[chunk]; i < wall_mesh.chunk_first[chunk + 1]; ++i) {
+    const TileRect& rect = wall_mesh.rects[i];
+    DrawRectangle(rect.col * tile_size, rect.row * tile_size,
+                  rect.width * tile_size, rect.height * tile_size, GREEN);
+  }
+}
+
+static void draw_item(const TileMap& tile_map, std::uint32_t col, std::uint16_t row, TILE_TYPE tile) {
+  const int tile_size = tile_map.tile_size;
+  const int half_tile = tile_size / 2;
+  const float radius = (tile == TILE_TYPE::PILL) ? 8.0f : 3.0f;
+  DrawCircle(static_cast<int>(col) * tile_size + half_tile, row * tile_size + half_tile, radius, MAROON);
+}
+
+// Dots and pills inside area
+static void draw_items(const TileMap& tile_map, const TileRect& area) {
+  const std::uint32_t end_col = std::uint32_t(area.col) + area.width;
+  if (area.width == 0) return;
+
+  for (std::uint16_t row = area.row; row < area.row + area.height; ++row) {
+    const std::uint64_t* dots  = tile_map.layer_row(TILE_TYPE::DOT, row);
+    const std::uint64_t* pills = tile_map.layer_row(TILE_TYPE::PILL, row);
+
+    for (std::uint32_t word = area.col >> 6; word <= (end_col - 1) >> 6; ++word) {
+      const std::uint64_t mask = get_span_mask(word, area.col, end_col);
+      for (std::uint64_t bits = dots[word] & mask; bits; bits &= bits - 1) {
+        draw_item(tile_map, word * 64u + ctz64(bits), row, TILE_TYPE::DOT);
+      }
+      for (std::uint64_t bits = pills[word] & mask; bits; bits &= bits - 1) {
+        draw_item(tile_map, word * 64u + ctz64(bits), row, TILE_TYPE::PILL);
+      }
+    }
+  }
+}
+
+// Render textures are stored upside down
+static void draw_render_texture(const RenderTexture2D& target, Vector2 position) {
+  const Rectangle src = { 0.0f, 0.0f, static_cast<float>(target.texture.width),
+                          -static_cast<float>(target.texture.height) };
+  DrawTextureRec(target.texture, src, position, WHITE);
+}
+
+// Tiles of a chunk, the ones on the right/bottom edges may be cut short
+static TileRect get_chunk_area(const TileMap& tile_map, std::uint32_t chunk_col, std::uint32_t chunk_row) {
+  const std::uint32_t col = chunk_col * MAP_CHUNK_TILES;
+  const std::uint32_t row = chunk_row * MAP_CHUNK_TILES;
+  return TileRect{
+    static_cast<std::uint16_t>(col), static_cast<std::uint16_t>(row),
+    static_cast<std::uint16_t>(std::min<std::uint32_t>(MAP_CHUNK_TILES, tile_map.cols - col)),
+    static_cast<std::uint16_t>(std::min<std::uint32_t>(MAP_CHUNK_TILES, tile_map.rows - row))
+  };
+}
+
+// Chunks overlapping view, clamped to the map
+static TileRect get_visible_chunks(const MapRenderCache& cache, const TileMap& tile_map, const Rectangle* view) {
+  if (!view) return TileRect{ 0, 0, cache.chunk_cols, cache.chunk_rows };
+
+  const float chunk_pixels = static_cast<float>(MAP_CHUNK_TILES * tile_map.tile_size);
+  const auto to_chunk = [](float chunk, std::uint16_t num_chunks) {
+    return static_cast<std::uint16_t>(Clamp(chunk, 0.0f, static_cast<float>(num_chunks)));
+  };
+  const std::uint16_t first_col = to_chunk(std::floor(view->x / chunk_pixels), cache.chunk_cols);
+  const std::uint16_t first_row = to_chunk(std::floor(view->y / chunk_pixels), cache.chunk_rows);
+  const std::uint16_t end_col = to_chunk(std::ceil((view->x + view->width) / chunk_pixels), cache.chunk_cols);
+  const std::uint16_t end_row = to_chunk(std::ceil((view->y + view->height) / chunk_pixels), cache.chunk_rows);
+  return TileRect{
+    first_col, first_row,
+    static_cast<std::uint16_t>(std::max(first_col, end_col) - first_col),
+    static_cast<std::uint16_t>(std::max(first_row, end_row) - first_row)
+  };
+}
+
+static void unload_map_chunk(MapRenderCache* cache, std::size_t baked_index) {
+  MapChunk& chunk = cache->chunks[cache->baked[baked_index]];
+  UnloadRenderTexture(chunk.target);
+  chunk.target = RenderTexture2D{};
+  cache->baked[baked_index] = cache->baked.back();
+  cache->baked.pop_back();
+}
+
+static void bake_map_chunk(MapRenderCache* cache, const TileMap& tile_map, std::uint32_t chunk_col,
+                           std::uint32_t chunk_row) {
+  const std::uint32_t index = chunk_row * cache->chunk_cols + chunk_col;
+  const TileRect area = get_chunk_area(tile_map, chunk_col, chunk_row);
+  const int tile_size = tile_map.tile_size;
+
+  // Makes room by dropping the least recently drawn chunk out of view
+  if (cache->baked.size() >= MAX_BAKED_MAP_CHUNKS) {
+    std::size_t oldest = cache->baked.size();
+    for (std::size_t i = 0; i < cache->baked.size(); ++i) {
+      const std::uint64_t last_used = cache->chunks[cache->baked[i]].last_used;
+      if (last_used < cache->num_syncs &&
+          (oldest == cache->baked.size() || last_used < cache->chunks[cache->baked[oldest]].last_used)) {
+        oldest = i;
+      }
+    }
+    if (oldest < cache->baked.size()) unload_map_chunk(cache, oldest);
+  }
+
+  MapChunk& chunk = cache->chunks[index];
+  chunk.target = LoadRenderTexture(area.width * tile_size, area.height * tile_size);
+  cache->baked.push_back(index);
+
+  BeginTextureMode(chunk.target);
+  ClearBackground(BLANK);
+  rlPushMatrix();
+  rlTranslatef(-static_cast<float>(area.col * tile_size), -static_cast<float>(area.row * tile_size), 0.0f);
+  draw_wall_chunk(cache->wall_mesh, index, tile_map.tile_size);
+  if (cache->dots.vao == 0) draw_items(tile_map, area);
+  rlPopMatrix();
+  EndTextureMode();
+
+  // The chunk's dots/pills are up to date from here on
+  const std::uint32_t end_col = std::uint32_t(area.col) + area.width;
+  for (std::uint32_t row = area.row; row < std::uint32_t(area.row) + area.height; ++row) {
+    const std::size_t row_word = std::size_t(row) * tile_map.words_per_row;
+    const std::uint64_t* dots = tile_map.layer_row(TILE_TYPE::DOT, static_cast<std::uint16_t>(row));
+    const std::uint64_t* pills = tile_map.layer_row(TILE_TYPE::PILL, static_cast<std::uint16_t>(row));
+    for (std::uint32_t word = area.col >> 6; word <= (end_col - 1) >> 6; ++word) {
+      const std::uint64_t mask = get_span_mask(word, area.col, end_col);
+      std::uint64_t& drawn_dots = cache->drawn_dots[row_word + word];
+      std::uint64_t& drawn_pills = cache->drawn_pills[row_word + word];
+      drawn_dots = (drawn_dots & ~mask) | (dots[word] & mask);
+      drawn_pills = (drawn_pills & ~mask) | (pills[word] & mask);
+    }
+  }
+}
+
+// Patches tiles of a baked chunk whose dot/pill changed. Their area is
+// overwritten with BLANK first, alpha blending would leave the old item in
+// place; dots and pills never share a tile with a wall.
+static void patch_map_chunk(MapRenderCache* cache, const TileMap& tile_map, std::uint32_t index) {
+  const TileRect area = get_chunk_area(tile_map, index % cache->chunk_cols, index / cache->chunk_cols);
+  const std::uint32_t end_col = std::uint32_t(area.col) + area.width;
+  const std::uint32_t end_row = std::uint32_t(area.row) + area.height;
+  const std::uint32_t first_word = area.col >> 6;
+  const std::uint32_t last_word = (end_col - 1) >> 6;
+  const std::uint16_t words_per_row = tile_map.words_per_row;
+  const std::uint64_t* dots = tile_map.layer_row(TILE_TYPE::DOT, 0);
+  const std::uint64_t* pills = tile_map.layer_row(TILE_TYPE::PILL, 0);
+  const int tile_size = tile_map.tile_size;
+
+  const auto get_changed = [&](std::size_t i, std::uint32_t word) {
+    return ((dots[i] ^ cache->drawn_dots[i]) | (pills[i] ^ cache->drawn_pills[i])) &
+           get_span_mask(word, area.col, end_col);
+  };
+
+  std::uint32_t first_changed_row = area.row;
+  for (; first_changed_row < end_row; ++first_changed_row) {
+    std::uint64_t changed = 0;
+    for (std::uint32_t word = first_word; word <= last_word; ++word) {
+      changed |= get_changed(std::size_t(first_changed_row) * words_per_row + word, word);
+    }
+    if (changed) break;
+  }
+  if (first_changed_row == end_row) return;
+
+  BeginTextureMode(cache->chunks[index].target);
+  rlPushMatrix();
+  rlTranslatef(-static_cast<float>(area.col * tile_size), -static_cast<float>(area.row * tile_size), 0.0f);
+  rlSetBlendFactors(RL_ONE, RL_ZERO, RL_FUNC_ADD);
+  BeginBlendMode(BLEND_CUSTOM);
+  for (std::uint32_t row = first_changed_row; row < end_row; ++row) {
+    for (std::uint32_t word = first_word; word <= last_word; ++word) {
+      for (std::uint64_t changed = get_changed(std::size_t(row) * words_per_row + word, word); changed;
+           changed &= changed - 1) {
+        const int pixel_x = static_cast<int>(word * 64u + ctz64(changed)) * tile_size;
+        DrawRectangle(pixel_x, static_cast<int>(row) * tile_size, tile_size, tile_size, BLANK);
+      }
+    }
+  }
+  EndBlendMode();
+
+  // Whatever is left on the erased tiles, e.g. everything after a new game
+  for (std::uint32_t row = first_changed_row; row < end_row; ++row) {
+    for (std::uint32_t word = first_word; word <= last_word; ++word) {
+      const std::size_t i = std::size_t(row) * words_per_row + word;
+      const std::uint64_t changed = get_changed(i, word);
+      const std::uint16_t tile_row = static_cast<std::uint16_t>(row);
+      for (std::uint64_t bits = dots[i] & changed; bits; bits &= bits - 1) {
+        draw_item(tile_map, word * 64u + ctz64(bits), tile_row, TILE_TYPE::DOT);
+      }
+      for (std::uint64_t bits = pills[i] & changed; bits; bits &= bits - 1) {
+        draw_item(tile_map, word * 64u + ctz64(bits), tile_row, TILE_TYPE::PILL);
+      }
+      cache->drawn_dots[i] ^= (dots[i] ^ cache->drawn_dots[i]) & changed;
+      cache->drawn_pills[i] ^= (pills[i] ^ cache->drawn_pills[i]) & changed;
+    }
+  }
+  rlPopMatrix();
+  EndTextureMode();
+}
+
+void sync_map_render_cache(MapRenderCache* cache, const TileMap& tile_map, const Rectangle* view) {
+  const std::uint16_t chunk_cols = static_cast<std::uint16_t>((tile_map.cols + MAP_CHUNK_TILES - 1) / MAP_CHUNK_TILES);
+  const std::uint16_t chunk_rows = static_cast<std::uint16_t>((tile_map.rows + MAP_CHUNK_TILES - 1) / MAP_CHUNK_TILES);
+
+  // New map or layout, every chunk is baked again once it's in view
+  if (cache->tile_map != &tile_map || cache->layout_version != tile_map.layout_version ||
+      cache->chunk_cols != chunk_cols || cache->chunk_rows != chunk_rows) {
+    unload_map_render_cache(cache);
+    cache->tile_map = &tile_map;
+    cache->layout_version = tile_map.layout_version;
+    cache->chunk_cols = chunk_cols;
+    cache->chunk_rows = chunk_rows;
+    cache->chunks.assign(std::size_t(chunk_cols) * chunk_rows, MapChunk{});
+    cache->drawn_dots = std::make_unique<std::uint64_t[]>(tile_map.layer_words());
+    cache->drawn_pills = std::make_unique<std::uint64_t[]>(tile_map.layer_words());
+    sync_wall_mesh(&cache->wall_mesh, tile_map, MAP_CHUNK_TILES);
+    build_dot_renderer(&cache->dots, tile_map, MAP_CHUNK_TILES);
+  }
+
+  ++cache->num_syncs;
+  cache->visible = get_visible_chunks(*cache, tile_map, view);
+  const TileRect& visible = cache->visible;
+
+  // Only flags change, unless dots show up where there were none
+  if (cache->dots.vao != 0) {
+    if (!sync_dot_renderer(&cache->dots, tile_map, visible)) {
+      build_dot_renderer(&cache->dots, tile_map, MAP_CHUNK_TILES);
+    }
+  } else {
+    for (const std::uint32_t index : cache->baked) patch_map_chunk(cache, tile_map, index);
+  }
+
+  for (std::uint32_t chunk_row = visible.row; chunk_row < std::uint32_t(visible.row) + visible.height; ++chunk_row) {
+    for (std::uint32_t chunk_col = visible.col; chunk_col < std::uint32_t(visible.col) + visible.width; ++chunk_col) {
+      MapChunk& chunk = cache->chunks[chunk_row * chunk_cols + chunk_col];
+      chunk.last_used = cache->num_syncs;
+      if (chunk.target.id == 0) bake_map_chunk(cache, tile_map, chunk_col, chunk_row);
+    }
+  }
+}
+
+void unload_map_render_cache(MapRenderCache* cache) {
+  while (!cache->baked.empty()) unload_map_chunk(cache, cache->baked.size() - 1);
+  unload_dot_renderer(&cache->dots);
+  cache->chunks.clear();
+  cache->chunk_cols = 0;
+  cache->chunk_rows = 0;
+  cache->visible = TileRect{};
+  cache->wall_mesh = WallMesh{};
+  cache->tile_map = nullptr;
+}
+
+// The baked chunks in view, then the instanced dots/pills over them
+static void draw_map_chunks(const MapRenderCache& cache, const TileMap& tile_map) {
+  const TileRect& visible = cache.visible;
+  const float chunk_pixels = static_cast<float>(MAP_CHUNK_TILES * tile_map.tile_size);
+  for (std::uint32_t chunk_row = visible.row; chunk_row < std::uint32_t(visible.row) + visible.height; ++chunk_row) {
+    for (std::uint32_t chunk_col = visible.col; chunk_col < std::uint32_t(visible.col) + visible.width; ++chunk_col) {
+      const MapChunk& chunk = cache.chunks[chunk_row * cache.chunk_cols + chunk_col];
+      if (chunk.target.id == 0) continue;
+      draw_render_texture(chunk.target, Vector2{ chunk_col * chunk_pixels, chunk_row * chunk_pixels });
+    }
+  }
+  if (cache.dots.vao != 0) draw_dot_renderer(cache.dots, MAROON, visible);
+}
+
+// Whether an entity is on the visible chunks or a tile away from them, it
+// can be drawn halfway to the next tile
+static bool is_entity_in_chunks(const EntityStore& entities, EntityId id, const TileRect& chunks) {
+  const TilePos pos = entities.tile_pos[id];
+  const int first_col = chunks.col * MAP_CHUNK_TILES - 1;
+  const int first_row = chunks.row * MAP_CHUNK_TILES - 1;
+  const int end_col = (chunks.col + chunks.width) * MAP_CHUNK_TILES + 1;
+  const int end_row = (chunks.row + chunks.height) * MAP_CHUNK_TILES + 1;
+  return pos.col >= first_col && pos.col < end_col && pos.row >= first_row && pos.row < end_row;
+}
+
+// visible_chunks culls the ghosts out of view, nullptr draws all of them.
+// Culled ghosts don't animate until they're back in view.
+static void draw_entities(const TileMap& tile_map, const EntityStore& entities,
+                          EntityRenderStore* render_store, const TileRect* visible_chunks,
+                          GHOST_STATE curr_ghost_state, float dt,
+                          float sim_remainder) {
+  // The player faces where he's heading, LEFT flips the sprite instead
+  // of rotating it (see get_dir_rotation)
+  EntityRender* player_render = &render_store->components[PLAYER_ID];
+  const MOVEMENT_DIR player_dir = entities.dir[PLAYER_ID];
+  player_render->rotation = get_dir_rotation(player_dir);
+  player_render->scale.y = get_dir_scale_y_sign(player_dir) * std::fabsf(player_render->scale.y);
+
+  // We use WHITE tint when we don't want any tint
+  render_entity(tile_map, entities, PLAYER_ID, player_render, WHITE, dt, sim_remainder);
+
+  // Get a color with  30% opacity, for ghosts when dead
+  Color dead_ghost_tint = WHITE;
+  dead_ghost_tint.a = static_cast<unsigned char>(255 * 0.3f);
+
+  for (EntityId ghost = PLAYER_ID + 1; ghost < entities.count; ++ghost) {
+    if (visible_chunks && !is_entity_in_chunks(entities, ghost, *visible_chunks)) continue;
+
+    Color tint = WHITE;
+    if (entities.is_dead[ghost]) {
+      tint = dead_ghost_tint;
+    } else if (curr_ghost_state == GHOST_STATE::FRIGHTENED) {
+      tint = DARKBLUE;
+    }
+
+    render_entity(tile_map, entities, ghost, &render_store->components[ghost],
+                  tint, dt, sim_remainder);
+  }
+}
+
+void draw_map_and_entities(const TileMap& tile_map, const EntityStore& entities,
+                           EntityRenderStore* render_store, const MapRenderCache* map_cache,
+                           GHOST_STATE curr_ghost_state, float dt,
+                           float sim_remainder, FrameProfiler* profiler) {
+  const bool cached = map_cache && map_cache->tile_map == &tile_map;
+  {
+    ProfileScope scope(profiler, "draw_map");
+    if (cached) {
+      draw_map_chunks(*map_cache, tile_map);
+    } else {
+      draw_walls(tile_map);
+      draw_items(tile_map, TileRect{ 0, 0, tile_map.cols, tile_map.rows });
+    }
+  }
+
+  ProfileScope scope(profiler, "draw_entities");
+  draw_entities(tile_map, entities, render_store, cached ? &map_cache->visible : nullptr,
+                curr_ghost_state, dt, sim_remainder);
+}
+
+Camera2D get_follow_camera(const TileMap& tile_map, Vector2 target,
+                           int screen_width, int screen_height) {
+  // Whole pixels, baked chunks would shimmer when sampled between texels
+  const auto follow = [](float target, float map_size, float screen_size) {
+    if (map_size <= screen_size) return 0.0f;
+    return std::round(Clamp(target - screen_size / 2.0f, 0.0f, map_size - screen_size));
+  };
+
+  Camera2D camera = {};
+  camera.target = Vector2{
+    follow(target.x, static_cast<float>(tile_map.cols * tile_map.tile_size), static_cast<float>(screen_width)),
+    follow(target.y, static_cast<float>(tile_map.rows * tile_map.tile_size), static_cast<float>(screen_height))
+  };
+  camera.zoom = 1.0f;
+  return camera;
+}
+
+Rectangle get_camera_view(const Camera2D& camera, int screen_width, int screen_height) {
+  return Rectangle{
+    camera.target.x - camera.offset.x / camera.zoom,
+    camera.target.y - camera.offset.y / camera.zoom,
+    static_cast<float>(screen_width) / camera.zoom,
+    static_cast<float>(screen_height) / camera.zoom
+  };
+}
+
+void draw_profiler_overlay(const FrameProfiler& profiler, int x, int y) {
+  constexpr std::uint32_t MAX_FRAME_SAMPLES = 512;
+  constexpr std::uint32_t MAX_PHASES = 16;
+  constexpr float FRAME_BUDGET_NS = 1e9f / 60.0f;
+  constexpr int BAR_WIDTH = 240;
+  constexpr int LINE_HEIGHT = 12;
+  static const Color PHASE_COLORS[] = { RED, ORANGE, GOLD, LIME, SKYBLUE, VIOLET, PINK, BEIGE };
+
+  ProfileSample samples[MAX_FRAME_SAMPLES];
+  const std::uint32_t count = read_profile_samples(profiler, samples, MAX_FRAME_SAMPLES);
+
+  // The frame scope ends after everything in it, so the newest one is last
+  std::uint32_t frame_idx = count;
+  while (frame_idx > 0 && samples[frame_idx - 1].depth != 0) --frame_idx;
+  if (frame_idx == 0) return;
+  const ProfileSample& frame = samples[frame_idx - 1];
+
+  // Same named scopes of the frame (e.g. every update_ghost) add up
+  struct Phase {
+    const char* name;
+    std::uint16_t depth;
+    std::uint64_t total_ns;
+  };
+  Phase phases[MAX_PHASES];
+  std::uint32_t num_phases = 0;
+  for (std::uint32_t i = 0; i + 1 < frame_idx; ++i) {
+    const ProfileSample& sample = samples[i];
+    if (sample.depth == 0 || sample.depth > 2 || sample.start_ns < frame.start_ns) continue;
+
+    std::uint32_t phase = 0;
+    while (phase < num_phases && std::strcmp(phases[phase].name, sample.name) != 0) ++phase;
+    if (phase == num_phases) {
+      if (num_phases == MAX_PHASES) continue;
+      phases[num_phases++] = Phase{ sample.name, sample.depth, 0 };
+    }
+    phases[phase].total_ns += sample.duration_ns;
+  }
+
+  const int height = LINE_HEIGHT * (static_cast<int>(num_phases) + 3);
+  DrawRectangle(x, y, BAR_WIDTH + 16, height, Fade(BLACK, 0.75f));
+  DrawText(TextFormat("frame %.2f ms", frame.duration_ns / 1e6), x + 8, y + 4, 10, RAYWHITE);
+
+  // Top level phases side by side, scaled to the frame budget
+  float bar_x = static_cast<float>(x + 8);
+  const int bar_y = y + 4 + LINE_HEIGHT;
+  for (std::uint32_t phase = 0; phase < num_phases; ++phase) {
+    if (phases[phase].depth != 1) continue;
+    const float width = BAR_WIDTH * (phases[phase].total_ns / FRAME_BUDGET_NS);
+    DrawRectangleRec(Rectangle{ bar_x, static_cast<float>(bar_y), width, LINE_HEIGHT - 2.0f },
+                     PHASE_COLORS[phase % 8]);
+    bar_x += width;
+  }
+  DrawRectangleLines(x + 8, bar_y, BAR_WIDTH, LINE_HEIGHT - 2, RAYWHITE);
+
+  for (std::uint32_t phase = 0; phase < num_phases; ++phase) {
+    const int line_y = bar_y + LINE_HEIGHT * (static_cast<int>(phase) + 1);
+    const int indent = 8 * phases[phase].depth;
+    DrawText(TextFormat("%s %.3f ms", phases[phase].name, phases[phase].total_ns / 1e6),
+             x + indent, line_y, 10,
+             (phases[phase].depth == 1) ? PHASE_COLORS[phase % 8] : LIGHTGRAY);
+  }
+}
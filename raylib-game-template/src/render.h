@@ -0,0 +1,121 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "raylib.h"
+#include "tile_map.h"
+#include "entity.h"
+#include "level.h"
+#include "ghosts.h"
+#include "profiler.h"
+#include "dot_renderer.h"
+#include "sprite_atlas.h"
+#include "wall_mesh.h"
+
+struct EntityAnimationContext {
+  Rectangle frame_rec;
+  std::uint32_t current_frame;
+  float time_accum = 0.0f;
+  std::uint32_t frames_speed;        // frames per second
+};
+
+// Render component of an entity, indexed like EntityStore
+struct EntityRender {
+  Texture2D texture{};
+  Rectangle sheet{};                 // the entity's spritesheet inside texture
+  Vector2 scale{1.5f, 1.5f};
+  float rotation{0.0f};
+  EntityAnimationContext anim_ctx{};
+};
+
+// Every entity sprite comes from the same atlas
+enum class ENTITY_SPRITE : std::uint8_t {
+  PACMAN,
+  BLINKY,
+  PINKY,
+  INKY,
+  CLYDE,
+  COUNT
+};
+
+// All spritesheets share one texture (see sprite_atlas.h), so the whole
+// entity pass is a single draw call. Ghosts of the same type share a
+// spritesheet, each ghost still animates on its own.
+struct EntityRenderStore {
+  SpriteAtlas atlas{};               // indexed by ENTITY_SPRITE
+  EntityRender components[MAX_ENTITIES]{};
+};
+
+// Side of the square chunks the maze is cached and culled by, in tiles
+constexpr std::uint16_t MAP_CHUNK_TILES = 32;
+// Chunk textures kept baked at most, past this the least recently drawn
+// ones go (never the ones in view)
+constexpr std::uint32_t MAX_BAKED_MAP_CHUNKS = 48;
+
+struct MapChunk {
+  RenderTexture2D target{};                  // id 0 until baked
+  std::uint64_t last_used{0};                // sync count it was last in view
+};
+
+// The maze drawn into render textures, a chunk of MAP_CHUNK_TILES at a time,
+// so a frame costs a textured quad per chunk in view instead of a draw call
+// per wall/dot/pill, and a maze bigger than the screen only bakes and draws
+// what the camera sees. Walls are baked from merged rectangles (see
+// wall_mesh.h), dots/pills too unless a DotRenderer instances them (OpenGL
+// 3.3). Tiles whose dot/pill changed since the last sync (usually the one
+// the player just ate) are patched in the chunks they belong to.
+struct MapRenderCache {
+  std::vector<MapChunk> chunks;              // chunk_cols * chunk_rows, row-major
+  std::uint16_t chunk_cols{0};
+  std::uint16_t chunk_rows{0};
+  TileRect visible{};                        // chunks in view at the last sync
+  std::vector<std::uint32_t> baked;          // chunks that have a target
+  std::uint64_t num_syncs{0};
+  DotRenderer dots{};
+  WallMesh wall_mesh{};
+  const TileMap* tile_map{nullptr};          // what it was baked for
+  std::uint32_t layout_version{0};
+  std::unique_ptr<std::uint64_t[]> drawn_dots;   // DOT/PILL bits in baked chunks
+  std::unique_ptr<std::uint64_t[]> drawn_pills;
+};
+
+// Everything in here needs a window/GL context, the simulation itself
+// (see sim.h) doesn't depend on any of it.
+void load_entity_texture(EntityRender* render, Texture2D texture, Rectangle sheet);
+void load_entities_textures(EntityRenderStore* render_store, const EntityStore& entities);
+void unload_entities_textures(EntityRenderStore* render_store);
+
+// Bakes or patches the chunks in view to match tile_map, call before
+// BeginDrawing(). view is the visible area in map pixels (see
+// get_camera_view), nullptr is the whole map.
+void sync_map_render_cache(MapRenderCache* cache, const TileMap& tile_map,
+                           const Rectangle* view = nullptr);
+void unload_map_render_cache(MapRenderCache* cache);
+
+// sim_remainder is the simulation time not yet stepped (see FixedStepClock),
+// entities are drawn that far ahead of their last tick
+void render_entity(const TileMap& tile_map, const EntityStore& entities, EntityId id,
+                   EntityRender* render, Color tint, float dt, float sim_remainder);
+// With a synced map_cache the maze comes from the chunks it has in view and
+// ghosts away from them aren't drawn, nullptr draws the whole map tile by
+// tile and every entity
+void draw_map_and_entities(const TileMap& tile_map, const EntityStore& entities,
+                           EntityRenderStore* render_store, const MapRenderCache* map_cache,
+                           GHOST_STATE curr_ghost_state, float dt,
+                           float sim_remainder, FrameProfiler* profiler = nullptr);
+
+// Camera that keeps target (in map pixels) in the middle of a screen of the
+// given size, without showing past the map's edges. A map smaller than the
+// screen stays at its top left.
+Camera2D get_follow_camera(const TileMap& tile_map, Vector2 target,
+                           int screen_width, int screen_height);
+// Map pixels a camera shows on a screen of the given size
+Rectangle get_camera_view(const Camera2D& camera, int screen_width, int screen_height);
+// Center of an entity in map pixels, drawn sim_remainder ahead of its last
+// tick like render_entity
+Vector2 get_entity_draw_pos(const TileMap& tile_map, const EntityStore& entities, EntityId id,
+                            float sim_remainder);
+
+// Breakdown of the last complete frame recorded by the profiler: a bar of
+// its phases against a 60 FPS budget and their times, nested ones indented
+void draw_profiler_overlay(const FrameProfiler& profiler, int x, int y);
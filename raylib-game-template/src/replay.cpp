@@ -0,0 +1,165 @@
+#include "replay.h"
+#include <cstdio>
+
+// "PMRP" and the format version. Bumped whenever the simulation stops
+// replaying older recordings the same, e.g. version 2 samples random values
+// differently (see get_sim_random_value) and version 3 hashes entity tiles
+// with mixed keys (see ZobristKeys). Version 4 added the level path.
+static constexpr std::uint8_t REPLAY_MAGIC[4] = { 'P', 'M', 'R', 'P' };
+static constexpr std::uint8_t REPLAY_VERSION = 4;
+
+void record_replay_input(Replay* replay, std::uint64_t tick, MOVEMENT_DIR dir) {
+  if (dir == MOVEMENT_DIR::STOPPED) return;
+  replay->inputs.push_back(ReplayInput{ tick, dir });
+}
+
+void finish_replay(Replay* replay, std::uint64_t num_ticks, const GameState& state) {
+  replay->num_ticks = num_ticks;
+  replay->final_dots = state.entities.collected_dots;
+  replay->final_hash = state.hash;
+}
+
+static void write_varint(std::vector<std::uint8_t>* bytes, std::uint64_t value) {
+  while (value >= 0x80) {
+    bytes->push_back(static_cast<std::uint8_t>(value | 0x80));
+    value >>= 7;
+  }
+  bytes->push_back(static_cast<std::uint8_t>(value));
+}
+
+static void write_u64(std::vector<std::uint8_t>* bytes, std::uint64_t value) {
+  for (int i = 0; i < 8; ++i) bytes->push_back(static_cast<std::uint8_t>(value >> (8 * i)));
+}
+
+// Bounds checked reading, every read fails once the data runs out
+struct ReplayReader {
+  const std::uint8_t* bytes;
+  std::size_t num_bytes;
+  std::size_t offset{0};
+
+  bool read_varint(std::uint64_t* value) {
+    *value = 0;
+    for (std::uint32_t shift = 0; shift < 64; shift += 7) {
+      if (offset >= num_bytes) return false;
+      const std::uint8_t byte = bytes[offset++];
+      *value |= std::uint64_t(byte & 0x7f) << shift;
+      if (!(byte & 0x80)) return true;
+    }
+    return false;
+  }
+
+  bool read_string(std::string* value) {
+    std::uint64_t length = 0;
+    if (!read_varint(&length) || length > num_bytes - offset) return false;
+    value->assign(reinterpret_cast<const char*>(bytes + offset), static_cast<std::size_t>(length));
+    offset += static_cast<std::size_t>(length);
+    return true;
+  }
+
+  bool read_u64(std::uint64_t* value) {
+    if (num_bytes - offset < 8) return false;
+    *value = 0;
+    for (int i = 0; i < 8; ++i) *value |= std::uint64_t(bytes[offset++]) << (8 * i);
+    return true;
+  }
+};
+
+void encode_replay(const Replay& replay, std::vector<std::uint8_t>* bytes) {
+  bytes->clear();
+  for (std::uint8_t byte : REPLAY_MAGIC) bytes->push_back(byte);
+  bytes->push_back(REPLAY_VERSION);
+  write_u64(bytes, replay.seed);
+  write_varint(bytes, replay.level_path.size());
+  bytes->insert(bytes->end(), replay.level_path.begin(), replay.level_path.end());
+  write_u64(bytes, replay.level_hash);
+  write_u64(bytes, replay.final_hash);
+  write_varint(bytes, replay.num_ticks);
+  write_varint(bytes, replay.final_dots);
+  write_varint(bytes, replay.inputs.size());
+
+  std::uint64_t prev_tick = 0;
+  for (const ReplayInput& input : replay.inputs) {
+    const std::uint64_t dir_bits = static_cast<std::uint8_t>(input.dir) - 1u;
+    write_varint(bytes, ((input.tick - prev_tick) << 2) | dir_bits);
+    prev_tick = input.tick;
+  }
+}
+
+bool decode_replay(const std::uint8_t* bytes, std::size_t num_bytes, Replay* replay) {
+  if (num_bytes < sizeof(REPLAY_MAGIC) + 1) return false;
+  for (std::size_t i = 0; i < sizeof(REPLAY_MAGIC); ++i) {
+    if (bytes[i] != REPLAY_MAGIC[i]) return false;
+  }
+  if (bytes[sizeof(REPLAY_MAGIC)] != REPLAY_VERSION) return false;
+
+  ReplayReader reader{ bytes, num_bytes, sizeof(REPLAY_MAGIC) + 1 };
+  std::uint64_t final_dots = 0;
+  std::uint64_t num_inputs = 0;
+  if (!reader.read_u64(&replay->seed) || !reader.read_string(&replay->level_path) ||
+      !reader.read_u64(&replay->level_hash) || !reader.read_u64(&replay->final_hash) ||
+      !reader.read_varint(&replay->num_ticks) ||
+      !reader.read_varint(&final_dots) || !reader.read_varint(&num_inputs)) {
+    return false;
+  }
+  // Every input takes at least a byte
+  if (final_dots > 0xffffffffu || num_inputs > num_bytes - reader.offset) return false;
+  replay->final_dots = static_cast<std::uint32_t>(final_dots);
+
+  replay->inputs.resize(num_inputs);
+  std::uint64_t tick = 0;
+  for (ReplayInput& input : replay->inputs) {
+    std::uint64_t packed = 0;
+    if (!reader.read_varint(&packed)) return false;
+    tick += packed >> 2;
+    input.tick = tick;
+    input.dir = static_cast<MOVEMENT_DIR>((packed & 3) + 1);
+  }
+  return reader.offset == num_bytes;
+}
+
+bool save_replay(const Replay& replay, const char* path) {
+  std::vector<std::uint8_t> bytes;
+  encode_replay(replay, &bytes);
+
+  std::FILE* file = std::fopen(path, "wb");
+  if (!file) return false;
+  const bool written = std::fwrite(bytes.data(), 1, bytes.size(), file) == bytes.size();
+  return (std::fclose(file) == 0) && written;
+}
+
+bool load_replay(Replay* replay, const char* path) {
+  std::FILE* file = std::fopen(path, "rb");
+  if (!file) return false;
+
+  std::vector<std::uint8_t> bytes;
+  std::uint8_t chunk[4096];
+  std::size_t num_read = 0;
+  while ((num_read = std::fread(chunk, 1, sizeof(chunk), file)) > 0) {
+    bytes.insert(bytes.end(), chunk, chunk + num_read);
+  }
+  std::fclose(file);
+  return decode_replay(bytes.data(), bytes.size(), replay);
+}
+
+ReplayCheck play_replay(GameSim* sim, GameState* state, const Replay& replay,
+                        GameLayers* layers) {
+  sim->reset(state, replay.seed, 0, layers);
+
+  std::size_t next_input = 0;
+  for (std::uint64_t tick = 0; tick < replay.num_ticks; ++tick) {
+    // Later inputs of the same tick override earlier ones, like in the game
+    MOVEMENT_DIR action = MOVEMENT_DIR::STOPPED;
+    while (next_input < replay.inputs.size() && replay.inputs[next_input].tick == tick) {
+      action = replay.inputs[next_input++].dir;
+    }
+    sim->step(state, action, SIM_TICK_DT, layers);
+  }
+
+  ReplayCheck check = {};
+  check.level_matches = sim->initial_state.hash == replay.level_hash;
+  check.final_dots = state->entities.collected_dots;
+  check.final_hash = state->hash;
+  check.dots_match = check.final_dots == replay.final_dots;
+  check.hash_matches = check.final_hash == replay.final_hash;
+  return check;
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "movement_dir.h"
+#include "game_state.h"
+#include "game_sim.h"
+
+// Input recordings of played games. A game is fully determined by its seed
+// and the player's inputs, so a replay only stores those plus what the game
+// ended with, to check a re-simulation against.
+//
+// On disk every input is a varint of the ticks since the previous input,
+// shifted left by 2 with the direction in the low bits: a whole session is
+// typically a few hundred bytes. The level is referred to by its path, the
+// level hash catches a file that changed since.
+
+struct ReplayInput {
+  std::uint64_t tick;                       // applied before this tick is simulated
+  MOVEMENT_DIR dir;                         // never STOPPED
+};
+
+struct Replay {
+  std::uint64_t seed{0};
+  std::string level_path;                   // as given to the game, empty for the classic maze
+  std::uint64_t level_hash{0};              // GameSim::initial_state.hash of the level
+  std::uint64_t num_ticks{0};               // ticks simulated in total
+  std::uint32_t final_dots{0};
+  std::uint64_t final_hash{0};
+  std::vector<ReplayInput> inputs;
+};
+
+// Records the player queuing dir before the given tick. Ticks have to be
+// recorded in order.
+void record_replay_input(Replay* replay, std::uint64_t tick, MOVEMENT_DIR dir);
+
+// Stores how the game ended (or where it stopped) after num_ticks ticks
+void finish_replay(Replay* replay, std::uint64_t num_ticks, const GameState& state);
+
+void encode_replay(const Replay& replay, std::vector<std::uint8_t>* bytes);
+
+// Returns false if the data isn't a valid replay
+bool decode_replay(const std::uint8_t* bytes, std::size_t num_bytes, Replay* replay);
+
+bool save_replay(const Replay& replay, const char* path);
+bool load_replay(Replay* replay, const char* path);
+
+struct ReplayCheck {
+  bool level_matches;
+  bool dots_match;
+  bool hash_matches;
+  std::uint32_t final_dots;
+  std::uint64_t final_hash;
+
+  bool ok() const { return level_matches && dots_match && hash_matches; }
+};
+
+// Re-simulates the replay through sim into *state, as fast as it goes.
+// layers is needed for big levels, see GameSim::needs_layers().
+ReplayCheck play_replay(GameSim* sim, GameState* state, const Replay& replay,
+                        GameLayers* layers = nullptr);
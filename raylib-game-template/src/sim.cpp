@@ -0,0 +1,67 @@
+#include "sim.h"
+#include "player.h"
+
+GAME_STATUS get_game_status(const TileMap& tile_map, const EntityStore& entities) {
+  if (entities.collected_dots >= tile_map.all_dots) return GAME_STATUS::WON;
+  if (entities.is_dead[PLAYER_ID]) return GAME_STATUS::LOST;
+  return GAME_STATUS::PLAYING;
+}
+
+std::uint16_t check_and_resolve_entity_collisions(EntityStore* entities) {
+  std::uint16_t ghosts_eaten = 0;
+  for (EntityId ghost = PLAYER_ID + 1; ghost < entities->count; ++ghost) {
+    if (entities->is_dead[ghost]) continue;
+
+    if (entity_collision(*entities, PLAYER_ID, ghost)) {
+      if (entities->is_energized) {
+        entities->is_dead[ghost] = true;
+        ++ghosts_eaten;
+      } else {
+        entities->is_dead[PLAYER_ID] = true;
+        break;
+      }
+    }
+  }
+  return ghosts_eaten;
+}
+
+StepEvents step_game(TileMap* tile_map, EntityStore* entities,
+                     GhostsStateMachine* ghosts_sm, const GhostContext& ghost_ctx,
+                     const double scatter_schedule[], const double chase_schedule[],
+                     float dt, const ZobristKeys* zobrist, std::uint64_t* hash) {
+  StepEvents events = {};
+
+  // Entities and the phase are rehashed as a whole, there are only a few of
+  // them. Collected tiles are xor-ed out below.
+  const bool update_hash = zobrist && hash;
+  if (update_hash) *hash ^= get_actors_zobrist(*zobrist, *entities, *ghosts_sm);
+
+  // Checks and resolves previous frames collisions. Doing it here
+  // prevents visual artifacts on collisions, due to the interpolation
+  // that's happening after an entity moves to a new tile.
+  {
+    ProfileScope scope(ghost_ctx.profiler, "collisions");
+    const bool was_dead = entities->is_dead[PLAYER_ID];
+    events.ghosts_eaten = check_and_resolve_entity_collisions(entities);
+    events.player_died = !was_dead && entities->is_dead[PLAYER_ID];
+  }
+
+  {
+    ProfileScope scope(ghost_ctx.profiler, "update_player");
+    const TilePos player_pos = entities->tile_pos[PLAYER_ID];
+    const TILE_TYPE collected = update_player(tile_map, entities, ghost_ctx.exit_masks, dt);
+    if (update_hash) *hash ^= get_tile_zobrist(*zobrist, collected, player_pos);
+    if (collected == TILE_TYPE::DOT) events.dots_eaten = 1;
+    if (collected == TILE_TYPE::PILL) events.pills_eaten = 1;
+  }
+
+  {
+    ProfileScope scope(ghost_ctx.profiler, "ghosts_sm");
+    update_ghosts_global_sm(ghosts_sm, entities->is_energized,
+                            scatter_schedule, chase_schedule, dt);
+  }
+  update_ghosts(entities, ghost_ctx, dt);
+
+  if (update_hash) *hash ^= get_actors_zobrist(*zobrist, *entities, *ghosts_sm);
+  return events;
+}
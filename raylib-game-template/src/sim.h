@@ -0,0 +1,69 @@
+#pragma once
+#include <cstdint>
+#include "tile_map.h"
+#include "level.h"
+#include "ghosts.h"
+#include "zobrist.h"
+
+// The simulation always advances in fixed ticks, independent of the render
+// frame rate, so the same inputs give the same results on any machine
+constexpr float SIM_TICK_RATE = 120.0f;
+constexpr float SIM_TICK_DT = 1.0f / SIM_TICK_RATE;
+
+// Frame time above this many ticks is dropped instead of being
+// simulated as a burst of catch-up ticks (e.g. after a window drag)
+constexpr std::uint32_t SIM_MAX_TICKS_PER_FRAME = 8;
+
+// Accumulates variable frame time and hands it out as fixed ticks
+struct FixedStepClock {
+  double accumulator{0.0};
+  std::uint64_t tick{0};            // ticks simulated so far
+
+  // Number of fixed ticks the caller has to simulate for this frame
+  std::uint32_t advance(double frame_dt) {
+    accumulator += frame_dt;
+    const double max_accumulated = SIM_MAX_TICKS_PER_FRAME * static_cast<double>(SIM_TICK_DT);
+    if (accumulator > max_accumulated) accumulator = max_accumulated;
+
+    std::uint32_t ticks = 0;
+    while (accumulator >= SIM_TICK_DT) {
+      accumulator -= SIM_TICK_DT;
+      ++ticks;
+    }
+    tick += ticks;
+    return ticks;
+  }
+
+  // Time not simulated yet, used to interpolate rendering between ticks
+  float remainder() const { return static_cast<float>(accumulator); }
+};
+
+enum class GAME_STATUS : std::uint8_t {
+  PLAYING = 0,
+  WON,
+  LOST,
+};
+
+GAME_STATUS get_game_status(const TileMap& tile_map, const EntityStore& entities);
+
+// What happened during a step_game() call, e.g. for rewarding agents
+struct StepEvents {
+  std::uint16_t dots_eaten{0};
+  std::uint16_t pills_eaten{0};
+  std::uint16_t ghosts_eaten{0};
+  bool player_died{false};
+};
+
+// Returns the number of ghosts eaten
+std::uint16_t check_and_resolve_entity_collisions(EntityStore* entities);
+
+// Advances the gameplay by dt, which should be SIM_TICK_DT: resolves the previous step's collisions, then
+// moves the player and the ghosts. Input and rendering are up to the caller,
+// nothing in here touches the window or the GPU.
+// With zobrist keys, *hash is updated to match the new state; it has to
+// match the old one going in (see compute_zobrist_hash()).
+StepEvents step_game(TileMap* tile_map, EntityStore* entities,
+                     GhostsStateMachine* ghosts_sm, const GhostContext& ghost_ctx,
+                     const double scatter_schedule[], const double chase_schedule[],
+                     float dt, const ZobristKeys* zobrist = nullptr,
+                     std::uint64_t* hash = nullptr);
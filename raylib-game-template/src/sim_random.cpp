@@ -0,0 +1,67 @@
+#include "sim_random.h"
+
+static std::uint64_t splitmix64(std::uint64_t* x) {
+  std::uint64_t z = (*x += 0x9e3779b97f4a7c15ull);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+  return z ^ (z >> 31);
+}
+
+static inline std::uint32_t rotate_left(std::uint32_t x, int k) {
+  return (x << k) | (x >> (32 - k));
+}
+
+static std::uint32_t xoshiro128ss(SimRandom* random) {
+  std::uint32_t* s = random->state;
+  const std::uint32_t result = rotate_left(s[1] * 5, 7) * 9;
+  const std::uint32_t t = s[1] << 9;
+
+  s[2] ^= s[0];
+  s[3] ^= s[1];
+  s[1] ^= s[2];
+  s[0] ^= s[3];
+  s[2] ^= t;
+  s[3] = rotate_left(s[3], 11);
+
+  return result;
+}
+
+void seed_sim_random(SimRandom* random, std::uint64_t seed) {
+  const std::uint64_t a = splitmix64(&seed);
+  const std::uint64_t b = splitmix64(&seed);
+  random->state[0] = static_cast<std::uint32_t>(a & 0xffffffff);
+  random->state[1] = static_cast<std::uint32_t>(a >> 32);
+  random->state[2] = static_cast<std::uint32_t>(b & 0xffffffff);
+  random->state[3] = static_cast<std::uint32_t>(b >> 32);
+}
+
+void seed_sim_random(SimRandom* random, std::uint64_t seed, std::uint64_t stream) {
+  seed_sim_random(random, seed ^ (stream * 0x9e3779b97f4a7c15ull));
+}
+
+SimRandom split_sim_random(SimRandom* random) {
+  // Jump polynomial from the Xoshiro128** reference implementation
+  static constexpr std::uint32_t jump[4] = { 0x8764000b, 0xf542d2d3, 0x6fa035c3, 0x77f2db5b };
+
+  const SimRandom split = *random;
+  std::uint32_t jumped[4] = { 0, 0, 0, 0 };
+  for (std::uint32_t word : jump) {
+    for (int bit = 0; bit < 32; ++bit) {
+      // All ones when the bit is set, keeps the loop branch free
+      const std::uint32_t take = 0u - ((word >> bit) & 1u);
+      for (int i = 0; i < 4; ++i) jumped[i] ^= random->state[i] & take;
+      xoshiro128ss(random);
+    }
+  }
+  for (int i = 0; i < 4; ++i) random->state[i] = jumped[i];
+  return split;
+}
+
+int get_sim_random_value(SimRandom* random, int min, int max) {
+  // Lemire's multiply-shift: the top 32 bits of x * range are evenly spread
+  // over [0, range), no division and no branch. A range of 2^32 (INT_MIN to
+  // INT_MAX) gives x itself.
+  const std::uint64_t range = static_cast<std::uint64_t>(std::int64_t(max) - std::int64_t(min)) + 1u;
+  const std::uint64_t offset = (std::uint64_t(xoshiro128ss(random)) * range) >> 32;
+  return static_cast<int>(std::int64_t(min) + static_cast<std::int64_t>(offset));
+}
@@ -0,0 +1,27 @@
+#pragma once
+#include <cstdint>
+
+// Simulation side stand-in for raylib's GetRandomValue(), so the simulation
+// doesn't have to link rcore. Same algorithm as rprand: Xoshiro128** with
+// the state initialized from the seed through SplitMix64.
+//
+// Every game owns its generator (see GhostContext), so any number of games
+// can run side by side and each one replays the same from its seed.
+struct SimRandom {
+  std::uint32_t state[4];
+};
+
+void seed_sim_random(SimRandom* random, std::uint64_t seed);
+
+// Seeds one of many independent streams of a seed, e.g. one per game
+void seed_sim_random(SimRandom* random, std::uint64_t seed, std::uint64_t stream);
+
+// Splits off a stream that doesn't overlap with what's left of random's:
+// the returned generator continues from the current state, random itself
+// jumps 2^64 values ahead
+SimRandom split_sim_random(SimRandom* random);
+
+// Random value between min and max included, min must not be above max.
+// Unlike GetRandomValue() the value comes from a multiply-shift rather than
+// a modulo, so small ranges don't favour their low values.
+int get_sim_random_value(SimRandom* random, int min, int max);
@@ -0,0 +1,78 @@
+#include "sprite_atlas.h"
+#include <algorithm>
+#include <cstdint>
+
+bool build_sprite_atlas(SpriteAtlas* atlas, const Image* images, std::size_t count, int padding) {
+  unload_sprite_atlas(atlas);
+  atlas->rects.assign(count, Rectangle{});
+
+  std::vector<std::size_t> order;
+  int max_width = 0;
+  std::int64_t area = 0;
+  for (std::size_t i = 0; i < count; ++i) {
+    if (images[i].data == nullptr || images[i].width <= 0 || images[i].height <= 0) continue;
+    order.push_back(i);
+    max_width = std::max(max_width, images[i].width);
+    area += std::int64_t(images[i].width + padding) * (images[i].height + padding);
+  }
+  if (order.empty()) return false;
+
+  std::stable_sort(order.begin(), order.end(), [images](std::size_t a, std::size_t b) {
+    return images[a].height > images[b].height;
+  });
+
+  // Power of two wide and about square, never narrower than the widest image
+  int width = 64;
+  while (width < max_width || std::int64_t(width) * width < area) width *= 2;
+
+  // Shelf packing: fill a row left to right, the first (tallest) image of
+  // the row sets its height
+  int x = 0;
+  int y = 0;
+  int shelf_height = 0;
+  for (std::size_t i : order) {
+    const Image& image = images[i];
+    if (x + image.width > width) {
+      x = 0;
+      y += shelf_height;
+      shelf_height = 0;
+    }
+    atlas->rects[i] = Rectangle{ static_cast<float>(x), static_cast<float>(y),
+                                 static_cast<float>(image.width), static_cast<float>(image.height) };
+    x += image.width + padding;
+    shelf_height = std::max(shelf_height, image.height + padding);
+  }
+
+  int height = 1;
+  while (height < y + shelf_height) height *= 2;
+
+  Image atlas_image = GenImageColor(width, height, BLANK);
+  for (std::size_t i : order) {
+    const Image& image = images[i];
+    const Rectangle src = { 0.0f, 0.0f, static_cast<float>(image.width), static_cast<float>(image.height) };
+    ImageDraw(&atlas_image, image, src, atlas->rects[i], WHITE);
+  }
+  atlas->texture = LoadTextureFromImage(atlas_image);
+  UnloadImage(atlas_image);
+  return atlas->texture.id != 0;
+}
+
+bool load_sprite_atlas(SpriteAtlas* atlas, const char* const* paths, std::size_t count) {
+  std::vector<Image> images(count);
+  for (std::size_t i = 0; i < count; ++i) {
+    images[i] = LoadImage(paths[i]);
+    if (images[i].data == nullptr) TraceLog(LOG_WARNING, "Sprite atlas: could not load %s", paths[i]);
+  }
+
+  const bool built = build_sprite_atlas(atlas, images.data(), count);
+  for (Image& image : images) {
+    UnloadImage(image);
+  }
+  return built;
+}
+
+void unload_sprite_atlas(SpriteAtlas* atlas) {
+  if (atlas->texture.id != 0) UnloadTexture(atlas->texture);
+  atlas->texture = Texture2D{};
+  atlas->rects.clear();
+}
@@ -0,0 +1,21 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+#include "raylib.h"
+
+// Several images packed into one texture, so sprites drawn from any of them
+// share a texture and raylib keeps them in a single batch (each texture
+// switch flushes a draw call).
+struct SpriteAtlas {
+  Texture2D texture{};
+  std::vector<Rectangle> rects;      // where each image ended up, in input order
+};
+
+// Images are packed in shelves, tallest first, padding pixels apart so
+// filtering doesn't bleed between neighbours. Returns false if nothing
+// could be packed.
+bool build_sprite_atlas(SpriteAtlas* atlas, const Image* images, std::size_t count, int padding = 1);
+// Same from image files, a missing one gets an empty rect and a warning in
+// the log
+bool load_sprite_atlas(SpriteAtlas* atlas, const char* const* paths, std::size_t count);
+void unload_sprite_atlas(SpriteAtlas* atlas);
@@ -0,0 +1,23 @@
+#include "tile_exit_masks.h"
+
+static void build_neighbour_masks(TileExitMasks* masks, const TileMap& tile_map) {
+  for (std::uint16_t row = 0; row < tile_map.rows; ++row) {
+    for (std::uint16_t col = 0; col < tile_map.cols; ++col) {
+      const std::size_t idx = tile_map.index(col, row);
+      masks->exit_mask[idx] = tile_map.get_walkable_neighbours_mask(col, row);
+      masks->door_mask[idx] = tile_map.get_neighbours_mask(TILE_TYPE::DOOR, col, row);
+    }
+  }
+}
+
+void sync_tile_exit_masks(TileExitMasks* masks, const TileMap& tile_map) {
+  if (are_exit_masks_valid(masks, tile_map)) return;
+
+  const std::size_t total_tiles = std::size_t(tile_map.rows) * tile_map.cols;
+  masks->layout = tile_map.layout_storage();
+  masks->layout_version = tile_map.layout_version;
+  masks->exit_mask = std::make_unique<std::uint8_t[]>(total_tiles);
+  masks->door_mask = std::make_unique<std::uint8_t[]>(total_tiles);
+
+  build_neighbour_masks(masks, tile_map);
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include "tile_map.h"
+#include "movement_dir.h"
+
+// Per tile neighbour masks derived from a TileMap. Movement code reads one
+// byte instead of probing four TileMap tiles, and inside a corridor (a
+// single exit besides the way back) ghosts take the only way on without
+// scoring candidates, so decisions only run at junctions. Entities still
+// move a tile at a time, there's no junction/corridor graph to skip along.
+//
+// The masks are only used while layout_version matches the map's, build them
+// with sync_tile_exit_masks() after loading a level or changing walls/doors.
+// They're read-only afterwards and valid for any map viewing the same
+// layout, so threads can share them.
+struct TileExitMasks {
+  const std::uint64_t* layout{nullptr};        // see TileMap::layout_storage()
+  std::uint32_t layout_version{0};
+  std::unique_ptr<std::uint8_t[]> exit_mask;   // tile index -> non-wall neighbours (get_dir_bit)
+  std::unique_ptr<std::uint8_t[]> door_mask;   // tile index -> door neighbours
+};
+
+// Rebuilds the masks if they were built for another map or an older layout
+void sync_tile_exit_masks(TileExitMasks* masks, const TileMap& tile_map);
+
+inline bool are_exit_masks_valid(const TileExitMasks* masks, const TileMap& tile_map) {
+  return masks && masks->layout == tile_map.layout_storage() &&
+         masks->layout_version == tile_map.layout_version && masks->exit_mask;
+}
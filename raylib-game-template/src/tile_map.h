@@ -2,6 +2,9 @@
 #include <cstdint>
 #include <cmath>
 #include <memory>
+#include <algorithm>
+#include "bits.h"
+#include "tile_pos.h"
 
 enum class TILE_TYPE : std::uint8_t {
   EMPTY = 0,
@@ -12,12 +15,87 @@ enum class TILE_TYPE : std::uint8_t {
   TELEPORT,
 };
 
+// Every non-empty tile type has its own bitboard layer,
+// the layer index is the TILE_TYPE value minus one
+constexpr std::uint8_t NUM_TILE_LAYERS = 5;
+
+inline bool is_layout_tile(TILE_TYPE tile) noexcept {
+  return tile == TILE_TYPE::WALL || tile == TILE_TYPE::DOOR ||
+         tile == TILE_TYPE::TELEPORT;
+}
+
+// Tiles are stored as one bitboard per tile type: each row is a run of
+// 64-bit words, one bit per column. That keeps large maps compact and lets
+// row/neighbour/count queries work a whole word at a time.
+//
+// Layers live in the map's own storage unless rebound with bind_layer(),
+// e.g. batched simulations keep every game's dots/pills in one slab and
+// point a single map at the game being stepped.
 struct TileMap {
   std::uint16_t tile_size;
   std::uint16_t rows;
   std::uint16_t cols;
-  std::uint16_t all_dots;
-  std::unique_ptr<TILE_TYPE[]> tiles;
+  std::uint32_t all_dots;
+  std::uint32_t layout_version;   // bumped whenever walls/doors/teleports change
+  std::uint16_t words_per_row;
+  std::unique_ptr<std::uint64_t[]> bits;   // owned storage, [layer][row][word]
+  std::uint64_t* layers[NUM_TILE_LAYERS];  // [row][word] per layer
+
+  // Allocates an all EMPTY map
+  inline void allocate(std::uint16_t num_cols, std::uint16_t num_rows) {
+    cols = num_cols;
+    rows = num_rows;
+    words_per_row = static_cast<std::uint16_t>((std::uint32_t(num_cols) + 63u) / 64u);
+    bits = std::make_unique<std::uint64_t[]>(layer_words() * NUM_TILE_LAYERS);
+    for (std::uint8_t layer = 0; layer < NUM_TILE_LAYERS; ++layer) {
+      layers[layer] = &bits[layer * layer_words()];
+    }
+  }
+
+  // Deep copy, layers bound elsewhere are copied into the new map's storage
+  inline void copy_from(const TileMap& other) {
+    tile_size = other.tile_size;
+    all_dots = other.all_dots;
+    layout_version = other.layout_version;
+    allocate(other.cols, other.rows);
+    for (std::uint8_t layer = 0; layer < NUM_TILE_LAYERS; ++layer) {
+      std::copy(other.layers[layer], other.layers[layer] + layer_words(), layers[layer]);
+    }
+  }
+
+  // Shallow copy, the layers point at other's (e.g. a mapped level's, see
+  // level_binary.h), which has to outlive this map
+  inline void view_of(const TileMap& other) noexcept {
+    tile_size = other.tile_size;
+    rows = other.rows;
+    cols = other.cols;
+    all_dots = other.all_dots;
+    layout_version = other.layout_version;
+    words_per_row = other.words_per_row;
+    bits.reset();
+    for (std::uint8_t layer = 0; layer < NUM_TILE_LAYERS; ++layer) layers[layer] = other.layers[layer];
+  }
+
+  // Points a layer at caller owned storage of layer_words() words. Only meant
+  // for DOT/PILL, rebinding layout layers doesn't bump layout_version.
+  inline void bind_layer(TILE_TYPE tile, std::uint64_t* words) noexcept {
+    layers[static_cast<std::size_t>(tile) - 1u] = words;
+  }
+
+  // Identifies the walls' storage, which maps viewing the same level share
+  // (see view_of()). Navigation data is keyed on it rather than on a map's
+  // address, so it serves every such map.
+  inline const std::uint64_t* layout_storage() const noexcept {
+    return layers[static_cast<std::size_t>(TILE_TYPE::WALL) - 1u];
+  }
+
+  inline std::size_t layer_words() const noexcept {
+    return std::size_t(rows) * std::size_t(words_per_row);
+  }
+
+  inline const std::uint64_t* layer_row(TILE_TYPE tile, std::uint16_t row) const noexcept {
+    return layers[static_cast<std::size_t>(tile) - 1u] + std::size_t(row) * words_per_row;
+  }
 
   inline bool in_bounds(std::uint16_t col, std::uint16_t row) const noexcept {
     return col < cols && row < rows;
@@ -27,8 +105,34 @@ struct TileMap {
     return std::size_t(row) * std::size_t(cols) + std::size_t(col);
   }
 
+  inline bool has(TILE_TYPE tile, std::uint16_t col, std::uint16_t row) const noexcept {
+    return (layer_row(tile, row)[col >> 6] >> (col & 63u)) & 1u;
+  }
+
   inline TILE_TYPE get(std::uint16_t col, std::uint16_t row) const noexcept {
-    return in_bounds(col, row) ? tiles[index(col, row)] : TILE_TYPE::EMPTY;
+    if (!in_bounds(col, row)) return TILE_TYPE::EMPTY;
+
+    const std::size_t word = std::size_t(row) * words_per_row + (col >> 6);
+    const std::uint64_t mask = std::uint64_t(1) << (col & 63u);
+    for (std::uint8_t layer = 0; layer < NUM_TILE_LAYERS; ++layer) {
+      if (layers[layer][word] & mask) return static_cast<TILE_TYPE>(layer + 1);
+    }
+    return TILE_TYPE::EMPTY;
+  }
+
+  inline bool in_bounds(TilePos pos) const noexcept {
+    return pos.col >= 0 && pos.row >= 0 &&
+           in_bounds(static_cast<std::uint16_t>(pos.col), static_cast<std::uint16_t>(pos.row));
+  }
+
+  inline std::size_t index(TilePos pos) const noexcept {
+    return index(static_cast<std::uint16_t>(pos.col), static_cast<std::uint16_t>(pos.row));
+  }
+
+  // Out of the map (including negative positions) reads as EMPTY
+  inline TILE_TYPE get(TilePos pos) const noexcept {
+    if (pos.col < 0 || pos.row < 0) return TILE_TYPE::EMPTY;
+    return get(static_cast<std::uint16_t>(pos.col), static_cast<std::uint16_t>(pos.row));
   }
 
   // Explicit float helpers — named to avoid confusion
@@ -45,7 +149,26 @@ struct TileMap {
     if (tile == TILE_TYPE::DOT) {
         ++all_dots; 
     }
-    tiles[index(col, row)] = tile;
+    const TILE_TYPE prev = get(col, row);
+    // Collecting dots/pills doesn't change the maze layout, anything
+    // else invalidates derived navigation data (see nav.h)
+    if (prev != tile && (is_layout_tile(prev) || is_layout_tile(tile))) {
+        ++layout_version;
+    }
+
+    const std::size_t word = std::size_t(row) * words_per_row + (col >> 6);
+    const std::uint64_t mask = std::uint64_t(1) << (col & 63u);
+    if (prev != TILE_TYPE::EMPTY) {
+      layers[static_cast<std::size_t>(prev) - 1u][word] &= ~mask;
+    }
+    if (tile != TILE_TYPE::EMPTY) {
+      layers[static_cast<std::size_t>(tile) - 1u][word] |= mask;
+    }
+  }
+
+  inline void set(TilePos pos, TILE_TYPE tile) noexcept {
+    if (pos.col < 0 || pos.row < 0) return;
+    set(static_cast<std::uint16_t>(pos.col), static_cast<std::uint16_t>(pos.row), tile);
   }
 
   inline void set(float col, float row, TILE_TYPE tile) noexcept {
@@ -54,5 +177,43 @@ struct TileMap {
     std::uint16_t int_row = static_cast<std::uint16_t>(std::floorf(row));
     set(int_col, int_row, tile);
   }
-};
 
+  // Number of tiles of the given type in a row, e.g. remaining dots
+  inline std::uint32_t count_in_row(TILE_TYPE tile, std::uint16_t row) const noexcept {
+    if (tile == TILE_TYPE::EMPTY || row >= rows) return 0;
+    const std::uint64_t* words = layer_row(tile, row);
+    std::uint32_t count = 0;
+    for (std::uint16_t w = 0; w < words_per_row; ++w) count += popcount64(words[w]);
+    return count;
+  }
+
+  // Number of tiles of the given type in the whole map
+  inline std::uint32_t count(TILE_TYPE tile) const noexcept {
+    if (tile == TILE_TYPE::EMPTY) return 0;
+    const std::uint64_t* words = layer_row(tile, 0);
+    const std::size_t total = layer_words();
+    std::uint32_t total_count = 0;
+    for (std::size_t w = 0; w < total; ++w) total_count += popcount64(words[w]);
+    return total_count;
+  }
+
+  // Neighbours of a tile that are of the given type, as a mask of
+  // get_dir_bit() bits: UP = 1, DOWN = 2, RIGHT = 4, LEFT = 8.
+  // Out of bounds neighbours never match.
+  inline std::uint8_t get_neighbours_mask(TILE_TYPE tile, std::uint16_t col,
+                                          std::uint16_t row) const noexcept {
+    if (tile == TILE_TYPE::EMPTY || !in_bounds(col, row)) return 0;
+    std::uint8_t mask = 0;
+    if (row > 0 && has(tile, col, row - 1))           mask |= 1u;
+    if (row + 1 < rows && has(tile, col, row + 1))    mask |= 2u;
+    if (col + 1 < cols && has(tile, col + 1, row))    mask |= 4u;
+    if (col > 0 && has(tile, col - 1, row))           mask |= 8u;
+    return mask;
+  }
+
+  // Neighbours that aren't walls. Out of bounds reads as EMPTY, like get().
+  inline std::uint8_t get_walkable_neighbours_mask(std::uint16_t col,
+                                                   std::uint16_t row) const noexcept {
+    return static_cast<std::uint8_t>(~get_neighbours_mask(TILE_TYPE::WALL, col, row) & 0x0fu);
+  }
+};
@@ -0,0 +1,41 @@
+#pragma once
+#include <cstdint>
+
+// Integer tile coordinates used throughout the simulation. Floats only show
+// up when rendering interpolates between two tiles. Can go negative/out of
+// the map, e.g. for targets ahead of the player.
+struct TilePos {
+  std::int16_t col{0};
+  std::int16_t row{0};
+};
+
+constexpr bool operator==(TilePos a, TilePos b) {
+  return a.col == b.col && a.row == b.row;
+}
+
+constexpr bool operator!=(TilePos a, TilePos b) {
+  return !(a == b);
+}
+
+constexpr TilePos operator+(TilePos a, TilePos b) {
+  return { static_cast<std::int16_t>(a.col + b.col), static_cast<std::int16_t>(a.row + b.row) };
+}
+
+constexpr TilePos operator-(TilePos a, TilePos b) {
+  return { static_cast<std::int16_t>(a.col - b.col), static_cast<std::int16_t>(a.row - b.row) };
+}
+
+constexpr TilePos operator*(TilePos a, int factor) {
+  return { static_cast<std::int16_t>(a.col * factor), static_cast<std::int16_t>(a.row * factor) };
+}
+
+constexpr std::int32_t get_tile_distance_sqr(TilePos a, TilePos b) {
+  const std::int32_t dx = std::int32_t(a.col) - b.col;
+  const std::int32_t dy = std::int32_t(a.row) - b.row;
+  return dx * dx + dy * dy;
+}
+
+// Both coordinates packed in one value, for hashing/comparing game state
+constexpr std::uint32_t pack_tile_pos(TilePos pos) {
+  return (std::uint32_t(std::uint16_t(pos.row)) << 16) | std::uint16_t(pos.col);
+}
@@ -0,0 +1,85 @@
+#include "vec_env.h"
+#include <algorithm>
+
+static GameLayers* get_env_layers(VecEnv* env, std::uint32_t env_idx) {
+  return env->sim.needs_layers() ? &env->layers[env_idx] : nullptr;
+}
+
+static void reset_env(VecEnv* env, std::uint32_t env_idx) {
+  // Games that restart keep drawing from the same random stream
+  GameState& state = env->states[env_idx];
+  const SimRandom random = state.random;
+  snapshot_game_state(env->sim.initial_state, &state);
+  if (env->sim.needs_layers()) copy_game_layers(env->sim.initial_layers, get_env_layers(env, env_idx));
+  state.random = random;
+  env->episode_steps[env_idx] = 0;
+}
+
+static void observe_env(VecEnv* env, std::uint32_t env_idx) {
+  const GameState& state = env->states[env_idx];
+  const EntityStore& entities = state.entities;
+  const TileMap& tile_map = env->sim.tile_map;
+  VecEnvObservation& obs = env->observations[env_idx];
+
+  obs.player_pos = entities.tile_pos[PLAYER_ID];
+  obs.player_dir = entities.dir[PLAYER_ID];
+  obs.is_energized = entities.is_energized;
+  obs.ghost_state = state.ghosts_sm.state;
+  obs.dots_left = tile_map.all_dots - std::min(tile_map.all_dots, entities.collected_dots);
+  obs.num_ghosts = entities.num_ghosts();
+  for (EntityId ghost = PLAYER_ID + 1; ghost < entities.count; ++ghost) {
+    obs.ghost_pos[ghost - 1] = entities.tile_pos[ghost];
+    obs.ghost_is_dead[ghost - 1] = entities.is_dead[ghost];
+  }
+}
+
+bool init_vec_env(VecEnv* env, const TileMap& level_map, const EntityStore& level_entities,
+                  const VecEnvConfig& config) {
+  env->config = config;
+  return init_game_sim(&env->sim, level_map, level_entities, config.sim);
+}
+
+void reset_vec_env(VecEnv* env, std::uint32_t num_envs) {
+  env->num_envs = num_envs;
+  env->states.resize(num_envs);
+  env->layers.resize(env->sim.needs_layers() ? num_envs : 0);
+  env->episode_steps.resize(num_envs);
+  env->observations.assign(num_envs, VecEnvObservation{});
+  env->rewards.assign(num_envs, 0.0f);
+  env->dones.assign(num_envs, 0);
+
+  for (std::uint32_t env_idx = 0; env_idx < num_envs; ++env_idx) {
+    env->sim.reset(&env->states[env_idx], env->config.seed, env_idx, get_env_layers(env, env_idx));
+    env->episode_steps[env_idx] = 0;
+    observe_env(env, env_idx);
+  }
+}
+
+void step_vec_env(VecEnv* env, const MOVEMENT_DIR* actions) {
+  const VecEnvConfig& config = env->config;
+
+  for (std::uint32_t env_idx = 0; env_idx < env->num_envs; ++env_idx) {
+    GameState& state = env->states[env_idx];
+    GameLayers* layers = get_env_layers(env, env_idx);
+
+    // The action only needs to be queued once, it sticks until taken
+    float reward = 0.0f;
+    GAME_STATUS status = GAME_STATUS::PLAYING;
+    MOVEMENT_DIR action = actions[env_idx];
+    for (std::uint32_t tick = 0; tick < config.ticks_per_step; ++tick) {
+      const StepResult result = env->sim.step(&state, action, SIM_TICK_DT, layers);
+      action = MOVEMENT_DIR::STOPPED;
+      reward += result.reward;
+      status = result.status;
+      if (status != GAME_STATUS::PLAYING) break;
+    }
+
+    const bool truncated = ++env->episode_steps[env_idx] >= config.max_episode_steps;
+    const bool done = status != GAME_STATUS::PLAYING || truncated;
+    env->rewards[env_idx] = reward;
+    env->dones[env_idx] = done ? 1 : 0;
+
+    if (done) reset_env(env, env_idx);
+    observe_env(env, env_idx);
+  }
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "tile_map.h"
+#include "entity.h"
+#include "ghosts.h"
+#include "game_state.h"
+#include "game_sim.h"
+
+// Batched simulation for training agents: N independent games stepped in
+// lockstep with the same logic as the game (see GameSim), without any
+// window or GPU calls. Games that end are reset on the spot, like a gym
+// vector environment, so every step() returns N usable observations.
+//
+// All games go through one GameSim, the per game state is one contiguous
+// array of GameState (plus a GameLayers each on levels bigger than 64x64).
+//
+// NOTE: don't move a VecEnv around after init_vec_env(), see GameSim
+
+struct VecEnvConfig {
+  std::uint32_t ticks_per_step{1};          // SIM_TICK_DT ticks per env step
+  std::uint32_t max_episode_steps{120 * 60 * 5};
+  GameSimConfig sim{};                      // rewards, ghosts and pen setup
+  std::uint64_t seed{1};                    // game i uses stream i of it
+};
+
+// What an agent gets to see of a game after each step
+struct VecEnvObservation {
+  TilePos player_pos;
+  MOVEMENT_DIR player_dir;
+  bool is_energized;
+  GHOST_STATE ghost_state;
+  std::uint32_t dots_left;
+  std::uint16_t num_ghosts;
+  TilePos ghost_pos[MAX_ENTITIES - 1];
+  bool ghost_is_dead[MAX_ENTITIES - 1];
+};
+
+struct VecEnv {
+  VecEnvConfig config{};
+  std::uint32_t num_envs{0};
+
+  // Shared by all games
+  GameSim sim{};
+
+  // Per game
+  std::vector<GameState> states;
+  std::vector<GameLayers> layers;           // empty unless sim.needs_layers()
+  std::vector<std::uint32_t> episode_steps;
+
+  // Results of the last reset/step, one per game
+  std::vector<VecEnvObservation> observations;
+  std::vector<float> rewards;
+  std::vector<std::uint8_t> dones;
+};
+
+// Takes a parsed level (see parse_level()) as the starting point of every
+// game. Returns false if the level doesn't fit in a GameState.
+bool init_vec_env(VecEnv* env, const TileMap& level_map, const EntityStore& level_entities,
+                  const VecEnvConfig& config);
+
+// (Re)starts num_envs games, observations are filled, rewards and dones cleared
+void reset_vec_env(VecEnv* env, std::uint32_t num_envs);
+
+// actions holds one direction per game, STOPPED keeps the current one.
+// Finished games report done and start over in the same call.
+void step_vec_env(VecEnv* env, const MOVEMENT_DIR* actions);
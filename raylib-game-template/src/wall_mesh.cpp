@@ -0,0 +1,106 @@
+#include "wall_mesh.h"
+#include <algorithm>
+
+// First column at or after start without a wall, runs can cross words
+static std::uint32_t find_span_end(const std::uint64_t* row, std::uint16_t words_per_row,
+                                   std::uint32_t start) {
+  std::uint32_t word = start >> 6;
+  std::uint64_t gaps = ~row[word] & (~std::uint64_t(0) << (start & 63u));
+  while (!gaps) {
+    if (++word == words_per_row) return std::uint32_t(words_per_row) * 64u;
+    gaps = ~row[word];
+  }
+  return word * 64u + ctz64(gaps);
+}
+
+static bool has_span(const std::uint64_t* row, std::uint32_t start, std::uint32_t end) {
+  for (std::uint32_t word = start >> 6; word <= (end - 1) >> 6; ++word) {
+    const std::uint64_t mask = get_span_mask(word, start, end);
+    if ((row[word] & mask) != mask) return false;
+  }
+  return true;
+}
+
+static void clear_span(std::uint64_t* row, std::uint32_t start, std::uint32_t end) {
+  for (std::uint32_t word = start >> 6; word <= (end - 1) >> 6; ++word) {
+    row[word] &= ~get_span_mask(word, start, end);
+  }
+}
+
+// Merges the walls of remaining inside area and clears them, rectangles are
+// appended
+static void append_wall_rects(std::uint64_t* remaining, std::uint16_t words_per_row,
+                              const TileRect& area, std::vector<TileRect>* rects) {
+  const std::uint32_t area_end = std::uint32_t(area.col) + area.width;
+  const std::uint32_t area_bottom = std::uint32_t(area.row) + area.height;
+  const std::uint32_t first_word = area.col >> 6;
+  const std::uint32_t last_word = (area_end - 1) >> 6;
+
+  for (std::uint32_t row = area.row; row < area_bottom; ++row) {
+    std::uint64_t* row_bits = &remaining[std::size_t(row) * words_per_row];
+
+    for (std::uint32_t word = first_word; word <= last_word; ++word) {
+      const std::uint64_t area_mask = get_span_mask(word, area.col, area_end);
+      while (row_bits[word] & area_mask) {
+        const std::uint32_t start = word * 64u + ctz64(row_bits[word] & area_mask);
+        const std::uint32_t end = std::min(find_span_end(row_bits, words_per_row, start), area_end);
+        clear_span(row_bits, start, end);
+
+        std::uint32_t height = 1;
+        while (row + height < area_bottom) {
+          std::uint64_t* below = &remaining[std::size_t(row + height) * words_per_row];
+          if (!has_span(below, start, end)) break;
+          clear_span(below, start, end);
+          ++height;
+        }
+
+        rects->push_back(TileRect{ static_cast<std::uint16_t>(start), static_cast<std::uint16_t>(row),
+                                   static_cast<std::uint16_t>(end - start),
+                                   static_cast<std::uint16_t>(height) });
+      }
+    }
+  }
+}
+
+void build_wall_rects(const TileMap& tile_map, std::vector<TileRect>* rects) {
+  rects->clear();
+  if (tile_map.cols == 0 || tile_map.rows == 0) return;
+
+  // Walls not merged yet, bits beyond cols are always clear
+  const std::uint64_t* walls = tile_map.layer_row(TILE_TYPE::WALL, 0);
+  std::vector<std::uint64_t> remaining(walls, walls + tile_map.layer_words());
+  append_wall_rects(remaining.data(), tile_map.words_per_row,
+                    TileRect{ 0, 0, tile_map.cols, tile_map.rows }, rects);
+}
+
+void sync_wall_mesh(WallMesh* mesh, const TileMap& tile_map, std::uint16_t chunk_tiles) {
+  if (mesh->tile_map == &tile_map && mesh->layout_version == tile_map.layout_version &&
+      mesh->chunk_tiles == chunk_tiles) {
+    return;
+  }
+
+  mesh->tile_map = &tile_map;
+  mesh->layout_version = tile_map.layout_version;
+  mesh->chunk_tiles = chunk_tiles;
+  mesh->chunk_cols = static_cast<std::uint16_t>((tile_map.cols + chunk_tiles - 1) / chunk_tiles);
+  mesh->chunk_rows = static_cast<std::uint16_t>((tile_map.rows + chunk_tiles - 1) / chunk_tiles);
+  mesh->rects.clear();
+  mesh->chunk_first.clear();
+
+  const std::uint64_t* walls = tile_map.layer_row(TILE_TYPE::WALL, 0);
+  std::vector<std::uint64_t> remaining(walls, walls + tile_map.layer_words());
+  for (std::uint32_t chunk_row = 0; chunk_row < mesh->chunk_rows; ++chunk_row) {
+    for (std::uint32_t chunk_col = 0; chunk_col < mesh->chunk_cols; ++chunk_col) {
+      const std::uint32_t col = chunk_col * chunk_tiles;
+      const std::uint32_t row = chunk_row * chunk_tiles;
+      const TileRect area = {
+        static_cast<std::uint16_t>(col), static_cast<std::uint16_t>(row),
+        static_cast<std::uint16_t>(std::min<std::uint32_t>(chunk_tiles, tile_map.cols - col)),
+        static_cast<std::uint16_t>(std::min<std::uint32_t>(chunk_tiles, tile_map.rows - row))
+      };
+      mesh->chunk_first.push_back(static_cast<std::uint32_t>(mesh->rects.size()));
+      append_wall_rects(remaining.data(), tile_map.words_per_row, area, &mesh->rects);
+    }
+  }
+  mesh->chunk_first.push_back(static_cast<std::uint32_t>(mesh->rects.size()));
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "tile_map.h"
+
+// Walls merged into as few rectangles as possible, so drawing them costs a
+// quad per rectangle instead of one per wall tile. Long corridor walls end
+// up as a single rectangle each.
+struct TileRect {
+  std::uint16_t col;
+  std::uint16_t row;
+  std::uint16_t width;         // in tiles
+  std::uint16_t height;
+};
+
+// Rectangles grouped by square chunks of the map, none crosses a chunk
+// edge, so a chunk can be drawn on its own (see MapRenderCache). Only valid
+// while its layout_version matches the map's, like TileExitMasks.
+struct WallMesh {
+  const TileMap* tile_map{nullptr};
+  std::uint32_t layout_version{0};
+  std::uint16_t chunk_tiles{0};
+  std::uint16_t chunk_cols{0};
+  std::uint16_t chunk_rows{0};
+  std::vector<TileRect> rects;
+  std::vector<std::uint32_t> chunk_first;    // rects of chunk i are [chunk_first[i], chunk_first[i + 1])
+};
+
+// Greedy merge: the first unmerged wall in reading order starts a
+// rectangle, which takes the whole run of walls to its right and then
+// grows down while the rows below have the same run. Every wall tile ends
+// up in exactly one rectangle.
+void build_wall_rects(const TileMap& tile_map, std::vector<TileRect>* rects);
+
+// Rebuilds the rectangles if they were built for another map, layout or
+// chunk size
+void sync_wall_mesh(WallMesh* mesh, const TileMap& tile_map, std::uint16_t chunk_tiles);
@@ -0,0 +1,69 @@
+#include "zobrist.h"
+#include "bits.h"
+
+static std::uint64_t splitmix64(std::uint64_t* x) {
+  std::uint64_t z = (*x += 0x9e3779b97f4a7c15ull);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+  return z ^ (z >> 31);
+}
+
+void init_zobrist_keys(ZobristKeys* keys, const TileMap& tile_map, std::uint64_t seed) {
+  const std::size_t total_tiles = std::size_t(tile_map.rows) * tile_map.cols;
+  keys->cols = tile_map.cols;
+  keys->rows = tile_map.rows;
+  keys->tiles = std::make_unique<std::uint64_t[]>(total_tiles);
+
+  for (std::size_t i = 0; i < total_tiles; ++i) keys->tiles[i] = splitmix64(&seed);
+  keys->pill_salt = splitmix64(&seed);
+
+  for (EntityId id = 0; id < MAX_ENTITIES; ++id) {
+    keys->entity_salts[id] = splitmix64(&seed);
+    for (std::uint64_t& key : keys->entity_dirs[id]) key = splitmix64(&seed);
+    keys->entity_dead[id] = splitmix64(&seed);
+    keys->entity_in_pen[id] = splitmix64(&seed);
+  }
+  keys->energized = splitmix64(&seed);
+  for (std::uint64_t& key : keys->ghost_states) key = splitmix64(&seed);
+  for (std::uint64_t& key : keys->change_seqs) key = splitmix64(&seed);
+}
+
+std::uint64_t get_actors_zobrist(const ZobristKeys& keys, const EntityStore& entities,
+                                 const GhostsStateMachine& ghosts_sm) {
+  std::uint64_t hash = 0;
+
+  for (EntityId id = 0; id < entities.count; ++id) {
+    const TilePos pos = entities.tile_pos[id];
+    if (pos.col >= 0 && pos.row >= 0 && pos.col < keys.cols && pos.row < keys.rows) {
+      const std::size_t idx = std::size_t(pos.row) * keys.cols + std::size_t(pos.col);
+      hash ^= mix_zobrist_key(keys.tiles[idx] ^ keys.entity_salts[id]);
+    }
+    hash ^= keys.entity_dirs[id][static_cast<std::uint8_t>(entities.dir[id])];
+    if (entities.is_dead[id]) hash ^= keys.entity_dead[id];
+    if (entities.in_monster_pen[id]) hash ^= keys.entity_in_pen[id];
+  }
+
+  if (entities.is_energized) hash ^= keys.energized;
+  hash ^= keys.ghost_states[static_cast<std::uint8_t>(ghosts_sm.state)];
+  hash ^= keys.change_seqs[ghosts_sm.change_seq & 255u];
+  return hash;
+}
+
+std::uint64_t compute_zobrist_hash(const ZobristKeys& keys, const TileMap& tile_map,
+                                   const EntityStore& entities,
+                                   const GhostsStateMachine& ghosts_sm) {
+  std::uint64_t hash = get_actors_zobrist(keys, entities, ghosts_sm);
+
+  for (TILE_TYPE tile : { TILE_TYPE::DOT, TILE_TYPE::PILL }) {
+    for (std::uint16_t row = 0; row < tile_map.rows; ++row) {
+      const std::uint64_t* words = tile_map.layer_row(tile, row);
+      for (std::uint16_t word = 0; word < tile_map.words_per_row; ++word) {
+        for (std::uint64_t bits = words[word]; bits; bits &= bits - 1) {
+          const std::int16_t col = static_cast<std::int16_t>(word * 64 + ctz64(bits));
+          hash ^= get_tile_zobrist(keys, tile, TilePos{ col, static_cast<std::int16_t>(row) });
+        }
+      }
+    }
+  }
+  return hash;
+}
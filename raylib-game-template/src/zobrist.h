@@ -0,0 +1,61 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include "tile_map.h"
+#include "entity.h"
+#include "ghosts.h"
+
+// Zobrist hashing of the discrete game state, for transposition tables in
+// search agents. The hash covers the remaining dots/pills, every entity's
+// tile, direction, dead and in-pen flags, the player being energized and
+// the ghost phase (state and change_seq). Sub-tile progress and timers
+// aren't hashed, states that only differ there hash the same.
+//
+// step_game() keeps a hash up to date when given the keys: collected tiles
+// are xor-ed out and only the entity/phase part is redone, so a step costs
+// O(entities) no matter how big the maze is.
+//
+// Only one random key is stored per tile, the pill and per entity keys of
+// a tile are mixed from it, so a 2048x2048 maze needs 32 MB of keys rather
+// than a key per entity and tile.
+struct ZobristKeys {
+  std::uint16_t cols{0};
+  std::uint16_t rows{0};
+  std::unique_ptr<std::uint64_t[]> tiles;          // per tile index, also the DOT key
+  std::uint64_t pill_salt;
+  std::uint64_t entity_salts[MAX_ENTITIES];
+  std::uint64_t entity_dirs[MAX_ENTITIES][5];      // by MOVEMENT_DIR
+  std::uint64_t entity_dead[MAX_ENTITIES];
+  std::uint64_t entity_in_pen[MAX_ENTITIES];
+  std::uint64_t energized;
+  std::uint64_t ghost_states[5];                   // by GHOST_STATE
+  std::uint64_t change_seqs[256];                  // by change_seq & 255
+};
+
+// Keys for maps of tile_map's size, the same seed always gives the same keys
+void init_zobrist_keys(ZobristKeys* keys, const TileMap& tile_map, std::uint64_t seed = 0x5eed);
+
+// SplitMix64's finalizer, turns a tile key and a salt into another key
+inline std::uint64_t mix_zobrist_key(std::uint64_t key) {
+  key = (key ^ (key >> 30)) * 0xbf58476d1ce4e5b9ull;
+  key = (key ^ (key >> 27)) * 0x94d049bb133111ebull;
+  return key ^ (key >> 31);
+}
+
+// Key of a DOT/PILL tile, 0 for anything else or out of the map
+inline std::uint64_t get_tile_zobrist(const ZobristKeys& keys, TILE_TYPE tile, TilePos pos) {
+  if (pos.col < 0 || pos.row < 0 || pos.col >= keys.cols || pos.row >= keys.rows) return 0;
+  const std::size_t idx = std::size_t(pos.row) * keys.cols + std::size_t(pos.col);
+  if (tile == TILE_TYPE::DOT) return keys.tiles[idx];
+  if (tile == TILE_TYPE::PILL) return mix_zobrist_key(keys.tiles[idx] ^ keys.pill_salt);
+  return 0;
+}
+
+// Entity and ghost phase part of the hash
+std::uint64_t get_actors_zobrist(const ZobristKeys& keys, const EntityStore& entities,
+                                 const GhostsStateMachine& ghosts_sm);
+
+// Full hash from scratch, the starting point for incremental updates
+std::uint64_t compute_zobrist_hash(const ZobristKeys& keys, const TileMap& tile_map,
+                                   const EntityStore& entities,
+                                   const GhostsStateMachine& ghosts_sm);